@@ -0,0 +1,389 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/*
+* load_test
+* Replays recorded games against a running chess server and reports throughput
+* and latency, e.g.
+*
+*   node server.js &
+*   ./load_test --games games.txt -c 64 --duration 30
+*
+* Each of the -c clients plays whole games over one keep-alive connection:
+* it opens a session with __INITIATE_GAME__ (keeping the session cookie the
+* server sets), sends every move of the game, then starts the next game in a
+* fresh session. Games come from --games, one per line as space-separated
+* moves ("1." style move numbers and lines starting with # are skipped), or
+* from a built-in set.
+*
+* --binary asks for the binary board records (format=binary) instead of text.
+*/
+
+namespace {
+
+const std::vector<std::string> BUILT_IN_GAMES = {
+    "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7",
+    "d4 d5 c4 e6 Nc3 Nf6 Bg5 Be7 e3 O-O",
+    "e4 c5 Nf3 d6 d4 cxd4 Nxd4 Nf6 Nc3 a6",
+    "c4 e5 Nc3 Nf6 Nf3 Nc6 g3 d5 cxd5 Nxd5",
+    "e4 e6 d4 d5 Nc3 Bb4 e5 c5 a3 Bxc3",
+};
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 3000;
+    std::string path = "/api/chess";
+    int clients = 8;
+    double duration = 10.0;  // seconds, unless `requests` is set
+    long requests = 0;
+    bool binary = false;
+    std::vector<std::vector<std::string>> games;
+};
+
+struct ClientStats {
+    std::vector<uint32_t> latencies_us;
+    long errors = 0;
+    long games = 0;
+};
+
+std::vector<std::vector<std::string>> load_games(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("load_test: cannot open " + path);
+    std::vector<std::vector<std::string>> games;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream words(line);
+        std::vector<std::string> moves;
+        std::string word;
+        while (words >> word) {
+            const size_t dot = word.find_last_of('.');
+            if (dot != std::string::npos) word = word.substr(dot + 1);  // "1.e4" or "1."
+            if (!word.empty()) moves.push_back(word);
+        }
+        if (!moves.empty()) games.push_back(moves);
+    }
+    if (games.empty()) throw std::runtime_error("load_test: no games in " + path);
+    return games;
+}
+
+std::string url_encode(const std::string& text) {
+    static const char HEX[] = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : text) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            out += static_cast<char>(c);
+        } else {
+            out += '%';
+            out += HEX[c >> 4];
+            out += HEX[c & 15];
+        }
+    }
+    return out;
+}
+
+// One keep-alive HTTP/1.1 connection to the server
+class Connection {
+public:
+    Connection(const Options& options) : options_(options) {}
+    ~Connection() { close(); }
+
+    // GET `target`, sending `cookie` if set and remembering the session cookie the server sets.
+    // Returns the status code. Throws std::runtime_error if the connection fails.
+    int get(const std::string& target, std::string& cookie) {
+        if (fd_ < 0) open();
+        std::string request = "GET " + target + " HTTP/1.1\r\nHost: " + options_.host + "\r\n";
+        if (!cookie.empty()) request += "Cookie: " + cookie + "\r\n";
+        request += "Connection: keep-alive\r\n\r\n";
+        send_all(request);
+
+        const std::string head = read_head();
+        int status = 0;
+        if (std::sscanf(head.c_str(), "HTTP/1.%*d %d", &status) != 1) throw std::runtime_error("bad status line");
+        long length = -1;
+        bool chunked = false;
+        bool closing = false;
+        std::istringstream lines(head);
+        std::string line;
+        while (std::getline(lines, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            const size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            std::string name = line.substr(0, colon);
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            std::string value = line.substr(colon + 1);
+            value.erase(0, value.find_first_not_of(' '));
+            if (name == "content-length") length = std::stol(value);
+            else if (name == "transfer-encoding") chunked = value.find("chunked") != std::string::npos;
+            else if (name == "connection") closing = value.find("close") != std::string::npos;
+            else if (name == "set-cookie") cookie = value.substr(0, value.find(';'));
+        }
+        if (chunked) {
+            while (true) {
+                const long size = std::stol(read_line(), nullptr, 16);
+                read_body(size);
+                read_line();  // CRLF after the chunk
+                if (size == 0) break;
+            }
+        } else if (length >= 0) {
+            read_body(length);
+        } else {
+            closing = true;  // body runs until the server closes
+        }
+        if (closing) close();
+        return status;
+    }
+
+    void close() {
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+        buffer_.clear();
+    }
+
+private:
+    void open() {
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* found = nullptr;
+        const int error = getaddrinfo(options_.host.c_str(), std::to_string(options_.port).c_str(), &hints, &found);
+        if (error != 0) throw std::runtime_error(std::string("getaddrinfo: ") + gai_strerror(error));
+        for (addrinfo* at = found; at != nullptr && fd_ < 0; at = at->ai_next) {
+            fd_ = socket(at->ai_family, at->ai_socktype, at->ai_protocol);
+            if (fd_ < 0) continue;
+            if (connect(fd_, at->ai_addr, at->ai_addrlen) != 0) {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+        freeaddrinfo(found);
+        if (fd_ < 0) throw std::runtime_error("cannot connect to " + options_.host + ":" + std::to_string(options_.port));
+        const int on = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+
+    void send_all(const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            const ssize_t n = ::send(fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) throw std::runtime_error("send failed");
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+    // Read more bytes into buffer_. Throws once the server has closed the connection.
+    void fill() {
+        char chunk[16384];
+        ssize_t n;
+        do {
+            n = ::recv(fd_, chunk, sizeof(chunk), 0);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) throw std::runtime_error("connection closed");
+        buffer_.append(chunk, static_cast<size_t>(n));
+    }
+
+    std::string read_head() {
+        size_t end;
+        while ((end = buffer_.find("\r\n\r\n")) == std::string::npos) fill();
+        std::string head = buffer_.substr(0, end + 2);
+        buffer_.erase(0, end + 4);
+        return head;
+    }
+
+    std::string read_line() {
+        size_t end;
+        while ((end = buffer_.find("\r\n")) == std::string::npos) fill();
+        std::string line = buffer_.substr(0, end);
+        buffer_.erase(0, end + 2);
+        return line;
+    }
+
+    void read_body(long length) {
+        while (static_cast<long>(buffer_.size()) < length) fill();
+        buffer_.erase(0, static_cast<size_t>(length));
+    }
+
+    const Options& options_;
+    int fd_ = -1;
+    std::string buffer_;
+};
+
+// Plays games until the deadline passes or the request budget is spent
+void run_client(const Options& options, std::atomic<long>& next_game, std::atomic<long>& budget,
+                std::chrono::steady_clock::time_point deadline, ClientStats& stats) {
+    Connection connection(options);
+    const std::string prefix = options.path + (options.binary ? "?format=binary&userMove=" : "?userMove=");
+    auto out_of_requests = [&] {
+        if (options.requests > 0) return budget.fetch_sub(1) <= 0;
+        return std::chrono::steady_clock::now() >= deadline;
+    };
+
+    while (true) {
+        const std::vector<std::string>& game = options.games[next_game.fetch_add(1) % options.games.size()];
+        std::string cookie;  // a fresh session for every game
+        std::vector<std::string> commands = {"__INITIATE_GAME__"};
+        commands.insert(commands.end(), game.begin(), game.end());
+        bool failed = false;
+        for (const std::string& command : commands) {
+            if (out_of_requests()) return;
+            const auto start = std::chrono::steady_clock::now();
+            int status = 0;
+            try {
+                status = connection.get(prefix + url_encode(command), cookie);
+            } catch (const std::exception&) {
+                connection.close();
+            }
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            if (status != 200) {
+                stats.errors++;
+                failed = true;
+                if (status == 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));  // server down: don't spin
+                continue;
+            }
+            stats.latencies_us.push_back(static_cast<uint32_t>(
+                std::min<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), UINT32_MAX)));
+        }
+        if (!failed) stats.games++;
+    }
+}
+
+// Latency below which `fraction` of the (sorted) samples fall
+uint32_t percentile(const std::vector<uint32_t>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    const size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+std::string format_us(uint32_t us) {
+    char text[32];
+    if (us < 1000) std::snprintf(text, sizeof(text), "%u us", us);
+    else if (us < 1000000) std::snprintf(text, sizeof(text), "%.2f ms", us / 1000.0);
+    else std::snprintf(text, sizeof(text), "%.2f s", us / 1e6);
+    return text;
+}
+
+void report(const std::vector<ClientStats>& clients, double seconds) {
+    std::vector<uint32_t> latencies;
+    long errors = 0;
+    long games = 0;
+    for (const ClientStats& client : clients) {
+        latencies.insert(latencies.end(), client.latencies_us.begin(), client.latencies_us.end());
+        errors += client.errors;
+        games += client.games;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::printf("requests   %zu ok, %ld failed, %ld games played without errors in %.2f s\n", latencies.size(), errors, games, seconds);
+    std::printf("throughput %.1f requests/s\n", latencies.size() / seconds);
+    if (latencies.empty()) return;
+    std::printf("latency    min %s  p50 %s  p90 %s  p99 %s  p99.9 %s  max %s\n",
+                format_us(latencies.front()).c_str(), format_us(percentile(latencies, 0.5)).c_str(),
+                format_us(percentile(latencies, 0.9)).c_str(), format_us(percentile(latencies, 0.99)).c_str(),
+                format_us(percentile(latencies, 0.999)).c_str(), format_us(latencies.back()).c_str());
+
+    // Histogram with power-of-two buckets
+    std::vector<size_t> buckets(33, 0);
+    for (uint32_t us : latencies) {
+        int bucket = 0;
+        while (bucket < 32 && (uint64_t{1} << (bucket + 1)) <= us) ++bucket;
+        buckets[bucket]++;
+    }
+    const size_t tallest = *std::max_element(buckets.begin(), buckets.end());
+    std::printf("\n%-12s %10s\n", "latency <", "requests");
+    for (int bucket = 0; bucket < 33; ++bucket) {
+        if (buckets[bucket] == 0) continue;
+        const std::string bar(static_cast<size_t>(50.0 * buckets[bucket] / tallest + 0.5), '#');
+        std::printf("%-12s %10zu %s\n", format_us(static_cast<uint32_t>(
+            std::min<uint64_t>(uint64_t{1} << (bucket + 1), UINT32_MAX))).c_str(), buckets[bucket], bar.c_str());
+    }
+}
+
+void usage() {
+    std::cerr << "usage: load_test [--host <host>] [--port <port>] [--path <path>] [-c <clients>]\n"
+                 "                 [--duration <seconds> | --requests <n>] [--games <file>] [--binary]\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool has_value = i + 1 < argc;
+            if (arg == "--host" && has_value) {
+                options.host = argv[++i];
+            } else if (arg == "--port" && has_value) {
+                options.port = std::stoi(argv[++i]);
+            } else if (arg == "--path" && has_value) {
+                options.path = argv[++i];
+            } else if ((arg == "-c" || arg == "--concurrency") && has_value) {
+                options.clients = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--duration" && has_value) {
+                options.duration = std::max(0.1, std::stod(argv[++i]));
+            } else if (arg == "--requests" && has_value) {
+                options.requests = std::max(1L, std::stol(argv[++i]));
+            } else if (arg == "--games" && has_value) {
+                options.games = load_games(argv[++i]);
+            } else if (arg == "--binary") {
+                options.binary = true;
+            } else {
+                usage();
+                return 1;
+            }
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << "\n";
+        usage();
+        return 1;
+    }
+    if (options.games.empty()) {
+        for (const std::string& line : BUILT_IN_GAMES) {
+            std::istringstream words(line);
+            std::vector<std::string> moves;
+            std::string word;
+            while (words >> word) moves.push_back(word);
+            options.games.push_back(moves);
+        }
+    }
+
+    std::cout << "load_test: " << options.clients << " clients against http://" << options.host << ":"
+              << options.port << options.path << ", ";
+    if (options.requests > 0) std::cout << options.requests << " requests\n";
+    else std::cout << options.duration << " s\n";
+
+    std::atomic<long> next_game{0};
+    std::atomic<long> budget{options.requests};
+    std::vector<ClientStats> stats(options.clients);
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(options.duration));
+    std::vector<std::thread> clients;
+    for (int c = 0; c < options.clients; ++c) {
+        clients.emplace_back(run_client, std::cref(options), std::ref(next_game), std::ref(budget), deadline,
+                             std::ref(stats[c]));
+    }
+    for (std::thread& client : clients) client.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report(stats, seconds);
+    return 0;
+}
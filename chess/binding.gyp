@@ -18,6 +18,30 @@
         "<!@(node -p \"require('node-addon-api').include\")"
       ],
       'defines': [ 'NAPI_DISABLE_CPP_EXCEPTIONS' ],
+    },
+    {
+      "target_name": "chess2",
+      "cflags!": [ "-fno-exceptions" ],
+      "cflags_cc!": [ "-fno-exceptions", "-std=gnu++14", "-std=gnu++1y" ],
+      "cflags_cc": [ "-std=c++17", "-O3" ],
+      "libraries": [ "-pthread" ],
+      'conditions': [
+        ['OS=="mac"', {
+          'xcode_settings': {
+            'GCC_ENABLE_CPP_EXCEPTIONS': 'YES',
+            'CLANG_CXX_LANGUAGE_STANDARD': 'c++17',
+            'GCC_OPTIMIZATION_LEVEL': '3'
+          }
+        }]
+      ],
+      "sources": [
+        "./src/chess2.cpp"
+      ],
+      "include_dirs": [
+        "<!@(node -p \"require('node-addon-api').include\")",
+        "../chess2/blackbox"
+      ],
+      'defines': [ 'NAPI_DISABLE_CPP_EXCEPTIONS' ],
     }
   ]
-}
\ No newline at end of file
+}
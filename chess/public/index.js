@@ -1,12 +1,42 @@
+// Board records from /api/chess?format=binary, see Game::record in src/game.hpp
+const RECORD_SIZE = 72;
+const OUTCOME = {STARTED: 0, PLAYED: 1, ILLEGAL: 2, MEANINGLESS: 3, QUIT: 4};
+const HORIZONTAL_LINE = '  ---------------------------------';
+const FILES = 'abcdefgh';
+
+// Draw a record the way the text endpoint does
+function renderRecord(record) {
+  const outcome = record[67];
+  if (outcome === OUTCOME.QUIT) return '';
+  if (outcome === OUTCOME.MEANINGLESS) return 'That move is meaningless. Try again.\n';
+
+  // An illegal move's record is followed by the reason it was refused
+  let text = outcome === OUTCOME.ILLEGAL
+    ? "Can't move there. ISSUE: " + new TextDecoder().decode(record.subarray(RECORD_SIZE)) + '\n'
+    : '';
+  text += HORIZONTAL_LINE + '\n';
+  for (let rank = 7; rank >= 0; rank--) {
+    text += (rank + 1) + ' |';
+    for (let file = 0; file < 8; file++) {
+      text += ' ' + String.fromCharCode(record[8 * rank + file]) + ' |';
+    }
+    text += '\n' + HORIZONTAL_LINE + '\n';
+  }
+  text += '    ' + FILES.split('').join('   ') + '  \n\n';
+  text += 'Input a move, or type QUIT to quit. Player to move: ' + (record[64] === 0 ? 'White' : 'Black') + '\n';
+  return text;
+}
+
 function playMove() {
   const userMove = document.getElementById('userMove').value;
 
-  fetch(`/api/chess?userMove=${userMove}`)
-    .then(response => response.json())
-    .then(data => {
+  fetch(`/api/chess?format=binary&userMove=${encodeURIComponent(userMove)}`)
+    .then(response => response.arrayBuffer())
+    .then(buffer => {
+      const record = new Uint8Array(buffer);
+      if (record.length < RECORD_SIZE) throw new Error('Unexpected board record');
       const outputElement = document.getElementById('output');
-      outputElement.textContent = data.board;
-      console.log(data.board);
+      outputElement.textContent = renderRecord(record);
     })
     .catch(error => {
       console.error('Error:', error);
@@ -1,23 +1,190 @@
 const express = require('express');
 const app = express();
 const path = require('path');
+const crypto = require('crypto');
 const chessModule = require('./build/Release/chess.node');
+const engine = require('./build/Release/chess2.node');
+
+// Each browser gets its own game, remembered by a cookie
+const SESSION_COOKIE = 'chessSession';
+chessModule.setMaxSessions(Number(process.env.CHESS_MAX_SESSIONS) || 10000);
+engine.setMaxSessions(Number(process.env.CHESS_MAX_SESSIONS) || 10000);
+
+// Work to finish before the process exits on SIGINT or SIGTERM
+const shutdownTasks = [];
+for (const signal of ['SIGINT', 'SIGTERM']) {
+  process.on(signal, async () => {
+    for (const task of shutdownTasks) await task();
+    process.exit(0);
+  });
+}
+
+// Engine results are cached in the addon. With CHESS_CACHE_FILE set, the cache
+// is loaded at startup and saved every few minutes and on shutdown.
+if (process.env.CHESS_CACHE_SIZE !== undefined) engine.setCacheSize(Number(process.env.CHESS_CACHE_SIZE));
+const cacheFile = process.env.CHESS_CACHE_FILE;
+if (cacheFile) {
+  try {
+    console.log(`Loaded ${engine.loadCache(cacheFile)} cached analyses from ${cacheFile}`);
+  } catch (err) {
+    console.log(`Starting with an empty analysis cache: ${err.message}`);
+  }
+  const saveCache = () => {
+    try {
+      engine.saveCache(cacheFile);
+    } catch (err) {
+      console.error(`Could not save the analysis cache: ${err.message}`);
+    }
+  };
+  setInterval(saveCache, 5 * 60 * 1000).unref();
+  shutdownTasks.push(saveCache);
+}
+
+// With CHESS_SNAPSHOT_DIR set, every game in play is restored at startup and
+// snapshotted every CHESS_SNAPSHOT_INTERVAL seconds (60 by default) and on
+// shutdown, so a restart does not lose them. Snapshots are written off the
+// event loop.
+const snapshotDir = process.env.CHESS_SNAPSHOT_DIR;
+if (snapshotDir) {
+  const snapshots = [
+    {addon: chessModule, file: path.join(snapshotDir, 'sessions-chess.bin')},
+    {addon: engine, file: path.join(snapshotDir, 'sessions-chess2.bin')},
+  ];
+  for (const {addon, file} of snapshots) {
+    try {
+      console.log(`Restored ${addon.loadSessions(file)} games from ${file}`);
+    } catch (err) {
+      console.log(`No games restored: ${err.message}`);
+    }
+  }
+  const saveSessions = () => Promise.all(snapshots.map(({addon, file}) =>
+    addon.saveSessions(file).catch(err => console.error(`Could not snapshot games: ${err.message}`))));
+  setInterval(saveSessions, (Number(process.env.CHESS_SNAPSHOT_INTERVAL) || 60) * 1000).unref();
+  shutdownTasks.push(saveSessions);
+}
+
+// Engine mate scores are infinite, which JSON cannot carry: send them as 'mate' or '-mate'
+function mateScores(key, value) {
+  return (typeof value === 'number' && !Number.isFinite(value)) ? (value > 0 ? 'mate' : '-mate') : value;
+}
+
+function sessionOf(req, res) {
+  const cookies = req.headers.cookie || '';
+  const match = cookies.match(new RegExp('(?:^|;\\s*)' + SESSION_COOKIE + '=([A-Za-z0-9-]+)'));
+  if (match) return match[1];
+  const id = crypto.randomUUID();
+  res.cookie(SESSION_COOKIE, id, {httpOnly: true, sameSite: 'lax'});
+  return id;
+}
 
 // Serve static files from the 'public' directory                                                                                                                         
 app.use(express.static('public'));
 
 // Define an API endpoint to handle the request                                                                                                                           
-app.get('/api/chess', (req, res) => {
+app.get('/api/chess', async (req, res) => {
   const userMove = req.query.userMove;
+  const session = sessionOf(req, res);
 
-  // Call your native module function and get the result
-  const board = chessModule.playMove(userMove);
+  // ?format=binary answers with the addon's board record (see Game::record
+  // in src/game.hpp) instead of a text board inside JSON
+  if (req.query.format === 'binary') {
+    try {
+      const record = await chessModule.playMoveBinaryAsync(session, String(userMove));
+      res.type('application/octet-stream').send(record);
+    } catch (err) {
+      res.status(500).json({error: String(err)});
+    }
+    return;
+  }
+
+  // The engine runs on libuv's thread pool, so other requests are served meanwhile
+  let board;
+  try {
+    board = await chessModule.playMoveAsync(session, String(userMove));
+  } catch (err) {
+    res.status(500).json({error: String(err)});
+    return;
+  }
 
   // Return the result as a JSON response                                                                                                                                 
   res.setHeader('Content-Type', 'application/json');
   res.json({board});
 });
 
+// Play against the chess2 engine: ?move=e4 plays a move and the engine's reply,
+// ?reset (optionally with &fen=...) starts over, no arguments returns the game state.
+app.get('/api/engine', async (req, res) => {
+  const session = sessionOf(req, res);
+  const options = {};
+  if (req.query.depth) options.depth = Number(req.query.depth);
+  try {
+    let result;
+    if (req.query.reset !== undefined) {
+      result = engine.newGame(session, req.query.fen ? String(req.query.fen) : undefined);
+    } else if (req.query.move) {
+      result = await engine.play(session, String(req.query.move), options);
+    } else {
+      result = engine.state(session);
+    }
+    res.json(result);
+  } catch (err) {
+    res.status(400).json({error: err.message});
+  }
+});
+
+// Stream an analysis of the current position as server-sent events: one
+// `data:` event per finished depth, then a `done` event with the best move.
+// Closing the connection stops the search.
+app.get('/api/engine/analysis', (req, res) => {
+  const session = sessionOf(req, res);
+  const options = {};
+  if (req.query.depth) options.depth = Number(req.query.depth);
+  const send = (event, data) => res.write(`event: ${event}\ndata: ${JSON.stringify(data, mateScores)}\n\n`);
+  let analysis;
+  try {
+    analysis = engine.analyze(session, options, update => send('update', update));
+  } catch (err) {
+    res.status(400).json({error: err.message});
+    return;
+  }
+  res.set({'Content-Type': 'text/event-stream', 'Cache-Control': 'no-cache', 'Connection': 'keep-alive'});
+  res.flushHeaders();
+  res.on('close', () => analysis.stop());
+  analysis.done.then(
+    result => send('done', result),
+    err => send('error', {error: err.message})
+  ).finally(() => res.end());
+});
+
+// Analyze many positions in one request: POST {positions: [fen, ...], depth, timeMs}.
+// They are searched in parallel on the addon's native thread pool; the answer
+// lists one evaluation per position, in order. The addon caps the number of
+// positions and the time spent on each, and closing the connection stops the batch.
+app.post('/api/engine/batch', express.json({limit: '64kb'}), async (req, res) => {
+  const {positions, depth, timeMs, evaluation} = req.body || {};
+  if (!Array.isArray(positions)) {
+    res.status(400).json({error: 'positions must be an array of FEN strings'});
+    return;
+  }
+  const options = {};
+  if (depth !== undefined) options.depth = Number(depth);
+  if (timeMs !== undefined) options.timeMs = Number(timeMs);
+  if (evaluation !== undefined) options.evaluation = String(evaluation);
+  try {
+    const batch = engine.analyzeBatch(positions.map(String), options);
+    res.on('close', () => batch.stop());
+    const results = await batch.done;
+    res.type('json').send(JSON.stringify({results}, mateScores));
+  } catch (err) {
+    res.status(400).json({error: err.message});
+  }
+});
+
+// Hit, miss and eviction counts of the engine's analysis cache
+app.get('/api/engine/cache', (req, res) => {
+  res.json(engine.cacheStats());
+});
+
 // Start the server and listen on a specific port                                                                                                                          
 const port = 3000;
 app.listen(port, () => {
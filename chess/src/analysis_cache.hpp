@@ -0,0 +1,241 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef CHESS_ANALYSIS_CACHE_H
+#define CHESS_ANALYSIS_CACHE_H
+
+constexpr std::size_t DEFAULT_ANALYSIS_CACHE_SIZE = 100000;
+constexpr std::size_t ANALYSIS_CACHE_SHARDS = 16;
+
+// A position and the budget it was searched with
+struct AnalysisKey {
+    uint64_t hash;  // Board::get_hash()
+    int depth;
+    int timeMs;  // the search's time budget
+    bool structural;
+
+    bool operator==(const AnalysisKey& k) const {
+        return hash == k.hash && depth == k.depth && timeMs == k.timeMs && structural == k.structural;
+    }
+};
+
+struct AnalysisKeyHash {
+    std::size_t operator()(const AnalysisKey& k) const {
+        uint64_t h = k.hash ^ (static_cast<uint64_t>(k.depth) << 56) ^ (static_cast<uint64_t>(k.timeMs) << 24)
+            ^ (k.structural ? 0x9E3779B97F4A7C15ull : 0);
+        return static_cast<std::size_t>(h ^ (h >> 29));
+    }
+};
+
+// What a search found. `move` is book::encode_move(), so it can be checked against the board.
+struct CachedAnalysis {
+    uint16_t move;
+    double score;  // for the side to move
+    bool scored;  // false for book or tablebase moves
+    int depth;  // deepest finished iteration
+};
+
+struct AnalysisCacheStats {
+    std::size_t entries;
+    std::size_t capacity;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+};
+
+/*
+AnalysisCache Class:
+--------------------
+Search results keyed by position and budget, so positions many clients reach
+(openings, shared puzzles) are searched once.
+
+Entries are spread over ANALYSIS_CACHE_SHARDS shards by key, each with its own
+lock, hash map and recency list, so concurrent searches rarely contend. Each
+shard holds its share of the capacity and evicts its least recently used
+entry when full.
+
+save() and load() keep the cache across restarts. File layout
+(little-endian): 8-byte magic "JCOCACH1", uint64 entry count, then 32-byte
+entries, least recently used first.
+*/
+class AnalysisCache {
+    struct Shard {
+        std::mutex mutex;
+        std::list<std::pair<AnalysisKey, CachedAnalysis>> byRecency;  // most recently used first
+        std::unordered_map<AnalysisKey, decltype(byRecency)::iterator, AnalysisKeyHash> entries;
+    };
+
+    // On-disk entry
+    struct Record {
+        uint64_t hash;
+        uint16_t move;
+        uint8_t depth;
+        uint8_t flags;  // 1 structural, 2 scored
+        int32_t timeMs;
+        double score;
+        int32_t reached;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(Record) == 32, "AnalysisCache::Record is part of the file format");
+    static constexpr char FILE_MAGIC[8] = {'J', 'C', 'O', 'C', 'A', 'C', 'H', '1'};
+
+    std::unique_ptr<Shard[]> shards;
+    std::atomic<std::size_t> capacity;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+
+    Shard& shardOf(const AnalysisKey& key) const {
+        return shards[AnalysisKeyHash{}(key) % ANALYSIS_CACHE_SHARDS];
+    }
+
+    std::size_t shardCapacity() const {
+        return (capacity.load() + ANALYSIS_CACHE_SHARDS - 1) / ANALYSIS_CACHE_SHARDS;
+    }
+
+    // Call with the shard locked
+    void shrink(Shard& shard, std::size_t size) {
+        while (shard.entries.size() > size) {
+            shard.entries.erase(shard.byRecency.back().first);
+            shard.byRecency.pop_back();
+            evictions++;
+        }
+    }
+
+public:
+    explicit AnalysisCache(std::size_t capacity = DEFAULT_ANALYSIS_CACHE_SIZE)
+        : shards(new Shard[ANALYSIS_CACHE_SHARDS]), capacity(capacity) {}
+
+    // The entry for `key`, marked as most recently used. Counts a hit or a miss.
+    std::optional<CachedAnalysis> find(const AnalysisKey& key) {
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.entries.find(key);
+        if (found == shard.entries.end()) {
+            misses++;
+            return {};
+        }
+        hits++;
+        shard.byRecency.splice(shard.byRecency.begin(), shard.byRecency, found->second);
+        return found->second->second;
+    }
+
+    void insert(const AnalysisKey& key, const CachedAnalysis& analysis) {
+        const std::size_t size = shardCapacity();
+        if (size == 0) return;
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.entries.find(key);
+        if (found != shard.entries.end()) {
+            found->second->second = analysis;
+            shard.byRecency.splice(shard.byRecency.begin(), shard.byRecency, found->second);
+            return;
+        }
+        shrink(shard, size - 1);
+        shard.byRecency.emplace_front(key, analysis);
+        shard.entries.emplace(key, shard.byRecency.begin());
+    }
+
+    // 0 turns the cache off. Shrinking evicts least recently used entries.
+    void setCapacity(std::size_t entries) {
+        capacity = entries;
+        const std::size_t size = shardCapacity();
+        for (std::size_t i = 0; i < ANALYSIS_CACHE_SHARDS; ++i) {
+            std::lock_guard<std::mutex> lock(shards[i].mutex);
+            shrink(shards[i], size);
+        }
+    }
+
+    void clear() {
+        for (std::size_t i = 0; i < ANALYSIS_CACHE_SHARDS; ++i) {
+            std::lock_guard<std::mutex> lock(shards[i].mutex);
+            shards[i].entries.clear();
+            shards[i].byRecency.clear();
+        }
+    }
+
+    AnalysisCacheStats stats() const {
+        std::size_t entries = 0;
+        for (std::size_t i = 0; i < ANALYSIS_CACHE_SHARDS; ++i) {
+            std::lock_guard<std::mutex> lock(shards[i].mutex);
+            entries += shards[i].entries.size();
+        }
+        return {entries, capacity.load(), hits.load(), misses.load(), evictions.load()};
+    }
+
+    // Write every entry to `path`, replacing it only once the new file is complete.
+    // Returns the number of entries written.
+    std::size_t save(const std::string& path) const {
+        std::vector<Record> records;
+        for (std::size_t i = 0; i < ANALYSIS_CACHE_SHARDS; ++i) {
+            std::lock_guard<std::mutex> lock(shards[i].mutex);
+            for (auto it = shards[i].byRecency.rbegin(); it != shards[i].byRecency.rend(); ++it) {
+                const AnalysisKey& key = it->first;
+                const CachedAnalysis& analysis = it->second;
+                Record record = {};
+                record.hash = key.hash;
+                record.move = analysis.move;
+                record.depth = static_cast<uint8_t>(key.depth);
+                record.flags = (key.structural ? 1 : 0) | (analysis.scored ? 2 : 0);
+                record.timeMs = key.timeMs;
+                record.score = analysis.score;
+                record.reached = analysis.depth;
+                records.push_back(record);
+            }
+        }
+
+        const std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            if (!out) throw std::runtime_error("AnalysisCache::save: cannot open " + temporary);
+            const uint64_t count = records.size();
+            out.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            out.write(reinterpret_cast<const char*>(records.data()),
+                      static_cast<std::streamsize>(records.size() * sizeof(Record)));
+            if (!out) throw std::runtime_error("AnalysisCache::save: write failed for " + temporary);
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("AnalysisCache::save: cannot replace " + path);
+        }
+        return records.size();
+    }
+
+    // Add the entries saved in `path`. Returns how many were read.
+    std::size_t load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("AnalysisCache::load: cannot open " + path);
+        char magic[sizeof(FILE_MAGIC)];
+        uint64_t count = 0;
+        in.read(magic, sizeof(magic));
+        in.read(reinterpret_cast<char*>(&count), sizeof(count));
+        if (!in || std::memcmp(magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+            throw std::runtime_error("AnalysisCache::load: bad magic in " + path);
+        }
+        Record record;
+        std::size_t read = 0;
+        for (; read < count; ++read) {
+            if (!in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+                throw std::runtime_error("AnalysisCache::load: truncated file " + path);
+            }
+            insert({record.hash, record.depth, record.timeMs, (record.flags & 1) != 0},
+                   {record.move, record.score, (record.flags & 2) != 0, record.reached});
+        }
+        return read;
+    }
+};
+
+#endif  // CHESS_ANALYSIS_CACHE_H
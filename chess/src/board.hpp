@@ -1,9 +1,9 @@
 #include <algorithm>
+#include <array>
 #include <string>
 #include <optional>
 #include <set>
 #include <utility>
-#include <unordered_set>
 #include <vector>
 #include "move.hpp"
 #include "piece.hpp"
@@ -34,43 +34,20 @@ class Board {
     std::vector<Piece> BPieces;
 
     // Redundant info but faster computation:
-    // Set of all the unoccupied squares
-    std::unordered_set<Square, SquareHash> Occupied;
-    // TODO implement? Makes colourPresent() faster
-    // Or instead just store the figures() map here instead of in State
-
-    // Return the index of a piece in the corresponding vector,
-    // and its colour, if it exists at that square. Else, return null.
-    // This only finds non-pawn non-king pieces, as per
-    // standard notation throughout this project.
-    std::optional<std::pair<size_t, Owner>> getPiece(Square s) const {
-        for (size_t idx=0; idx<WPieces.size(); idx++) {
-            if (WPieces[idx].square == s) return {{idx, Owner::WHITE}};
-        }
-        for (size_t idx=0; idx<BPieces.size(); idx++) {
-            if (BPieces[idx].square == s) return {{idx, Owner::BLACK}};
-        }
-        return {};
-    }
-
-    // Returns Owner of the king situated on the argument square.
-    // If argument square doesn't contain a king, returns null.
-    std::optional<Owner> getKing(Square s) const {
-        if (WKing == s) return Owner::WHITE;
-        if (BKing == s) return Owner::BLACK;
-        return {};
-    }
-
-    // Returns the index of a pawn in the corresponding vector,
-    // and its colour, if it exists at that square. Else return null.
-    std::optional<std::pair<size_t, Owner>> getPawn(Square s) const {
-        for (size_t idx=0; idx<WPawns.size(); idx++) {
-            if (WPawns[idx] == s) return {{idx, Owner::WHITE}};
-        }
-        for (size_t idx=0; idx<BPawns.size(); idx++) {
-            if (BPawns[idx] == s) return {{idx, Owner::BLACK}};
-        }
-        return {};
+    // The figure on each square, indexed by Square::index(), so finding
+    // what (if anything) stands on a square is a single array access.
+    // Kept in step with the vectors above by teletransport() and kill().
+    std::array<std::optional<Figure>, 64> mailbox;
+
+    // Fill the mailbox from the kings, pawns and pieces vectors
+    void fillMailbox() {
+        mailbox.fill(std::nullopt);
+        mailbox[WKing.index()] = Figure{Owner::WHITE, true};
+        mailbox[BKing.index()] = Figure{Owner::BLACK, true};
+        for (const Square& s : WPawns) mailbox[s.index()] = Figure{Owner::WHITE, false};
+        for (const Square& s : BPawns) mailbox[s.index()] = Figure{Owner::BLACK, false};
+        for (const Piece& p : WPieces) mailbox[p.square.index()] = Figure{p.shape, Owner::WHITE};
+        for (const Piece& p : BPieces) mailbox[p.square.index()] = Figure{p.shape, Owner::BLACK};
     }
 
     /*
@@ -217,69 +194,52 @@ class Board {
     // Teletransport figure from start to end square. Do nothing else.
     // If assumptions broken, method has undefined behaviour
     void teletransport(Square start, Square end) {
-
-        // Move kings
-        if (WKing == start) {
-            WKing = end;
-            return;
-        }
-        if (BKing == start) {
-            BKing = end;
-            return;
+        const std::optional<Figure> f = figureAt(start);
+        if (!f.has_value() || !end.isValid()) {
+            throw std::invalid_argument{"Cannot teletransport"};
         }
-
-        // Move pawns
-        auto pawn = getPawn(start);
-        if (pawn.has_value()) {
-            if (pawn.value().second == Owner::WHITE) {
-                WPawns[pawn.value().first] = end;
-            } else {
-                BPawns[pawn.value().first] = end;
-            }
-            return;
-        }
-
-        // Move piece
-        auto piece = getPiece(start);
-        if (piece.has_value()) {
-            if (piece.value().second == Owner::WHITE) {
-                WPieces[piece.value().first] = Piece{end, WPieces[piece.value().first].shape};
-            } else {
-                BPieces[piece.value().first] = Piece{end, BPieces[piece.value().first].shape};
-            }
-            return;
+        bool white = (f.value().colour == Owner::WHITE);
+
+        if (f.value().king) {
+            // Move kings
+            (white ? WKing : BKing) = end;
+        } else if (!f.value().shape.has_value()) {
+            // Move pawns
+            std::vector<Square>& pawns = (white ? WPawns : BPawns);
+            *std::find(pawns.begin(), pawns.end(), start) = end;
+        } else {
+            // Move piece
+            std::vector<Piece>& pieces = (white ? WPieces : BPieces);
+            std::find_if(pieces.begin(), pieces.end(),
+                [start](const Piece& p) {return p.square == start;})->square = end;
         }
 
-        throw std::invalid_argument{"Cannot teletransport"};
+        mailbox[end.index()] = f;
+        mailbox[start.index()].reset();
     }
 
     // Assume a non-king figure exists on the square, then kill it
-    // If a king is there, or if the square is empty, this is undefined
+    // If a king is there, or if the square is empty, this throws
+    // and the board is left untouched
     void kill(Square s) {
-
-        // Kill pawns
-        auto pawn = getPawn(s);
-        if (pawn.has_value()) {
-            if (pawn.value().second == Owner::WHITE) {
-                WPawns.erase(WPawns.begin() + pawn.value().first);
-            } else {
-                BPawns.erase(BPawns.begin() + pawn.value().first);
-            }
-            return;
+        const std::optional<Figure>& f = figureAt(s);
+        if (!f.has_value() || f.value().king) {
+            throw std::invalid_argument{"Cannot Kill"};
         }
+        bool white = (f.value().colour == Owner::WHITE);
 
-        // Kill piece
-        auto piece = getPiece(s);
-        if (piece.has_value()) {
-            if (piece.value().second == Owner::WHITE) {
-                WPieces.erase(WPieces.begin() + piece.value().first);
-            } else {
-                BPieces.erase(BPieces.begin() + piece.value().first);
-            }
-            return;
+        if (!f.value().shape.has_value()) {
+            // Kill pawns
+            std::vector<Square>& pawns = (white ? WPawns : BPawns);
+            pawns.erase(std::find(pawns.begin(), pawns.end(), s));
+        } else {
+            // Kill piece
+            std::vector<Piece>& pieces = (white ? WPieces : BPieces);
+            pieces.erase(std::find_if(pieces.begin(), pieces.end(),
+                [s](const Piece& p) {return p.square == s;}));
         }
 
-        throw std::invalid_argument{"Cannot Kill"};
+        mailbox[s.index()].reset();
     }
     
 public:
@@ -323,7 +283,9 @@ public:
             // ROOKS
             {{"a8"}, Shape::ROOK},
             {{"h8"}, Shape::ROOK},
-        } {}
+        } {
+        fillMailbox();
+    }
 
     // Compare two board states (without game history)
     bool operator==(const Board& b) const {
@@ -357,14 +319,16 @@ public:
         return true;
     }
 
+    // Return the figure on a square, if any. Invalid squares are empty.
+    const std::optional<Figure>& figureAt(Square s) const {
+        static const std::optional<Figure> none;
+        return s.isValid() ? mailbox[s.index()] : none;
+    }
+
     // Return whether or not a white/black piece is there
     std::optional<Owner> colourPresent(Square s) const {
-        auto p = getPiece(s);
-        if (p.has_value()) return p.value().second;
-        auto pa = getPawn(s);
-        if (pa.has_value()) return pa.value().second;
-        auto pk = getKing(s);
-        if (pk.has_value()) return pk.value();
+        const std::optional<Figure>& f = figureAt(s);
+        if (f.has_value()) return f.value().colour;
         return {};
     }
 
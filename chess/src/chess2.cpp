@@ -0,0 +1,869 @@
+#include <napi.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "algebraic_notation.h"
+#include "dfs.h"
+#include "fen.h"
+#include "game.h"
+#include "lawyer.h"
+#include "oracle.h"
+#include "uci.h"
+#include "analysis_cache.hpp"
+#include "session_registry.hpp"
+#include "session_snapshot.hpp"
+#include "thread_pool.hpp"
+
+/*
+chess2 addon:
+-------------
+Wraps the chess2/blackbox engine (Game, Lawyer, DFS) for Node, one game per
+session id like the chess addon. Searches run on the addon's own native
+thread pools and return promises; everything else is synchronous and cheap.
+
+  newGame(sessionId[, fen])             -> state
+  state(sessionId)                      -> state
+  legalMoves(sessionId)                 -> [san]
+  move(sessionId, move)                 -> state            (SAN or UCI, e.g. "Nf3" or "g1f3")
+  engineMove(sessionId[, options])      -> Promise<result>  (the engine plays the side to move)
+  play(sessionId, move[, options])      -> Promise<result>  (move, then the engine's reply)
+  analyze(sessionId, options, onUpdate) -> { stop(), done: Promise<analysis> }
+  analyzeBatch([fen], options)          -> { stop(), done: Promise<[evaluation]> }
+  cacheStats(), setCacheSize(n), clearCache(), saveCache(path), loadCache(path)
+  saveSessions(path) -> Promise<count>, loadSessions(path) -> count
+  endSession(sessionId), setMaxSessions(n), sessionCount()
+
+state is { fen, status, winner, toMove }; result adds { move, uci } for the
+engine's move (absent if the game was already over). options are
+{ depth, timeMs, evaluation: "material" | "structural" }: depth is at most
+ENGINE_MAX_DEPTH, and every search stops deepening after timeMs milliseconds,
+at most and by default ENGINE_MAX_TIME_MS, answering with its deepest finished
+iteration. This DFS has no pruning, so these limits are what keep one request
+from holding a thread for minutes. The session is not locked
+while the engine searches; if its game changes meanwhile, the promise rejects
+and the engine's move is not played. Engine moves are searched on their own
+pool of native threads, ENGINE_MOVES_PER_THREAD per thread at most, counting
+those waiting their turn; beyond that the promise rejects at once.
+
+analyze() deepens on a fixed pool of native threads, from a copy of the
+session's position. Up to ANALYSES_PER_THREAD analyses per thread may wait
+their turn; beyond that analyze() throws. It calls onUpdate({ depth, score, pv, nodes, nps, timeMs }) on the event
+loop after every finished depth; score is for the side to move and pv is in
+UCI notation. done resolves to { move, uci, depth, stopped } once the search
+ends, with move null if it was stopped before depth 1, and stopped also set
+when options.timeMs ran out first. Starting another analysis, or any call that
+changes or ends the session's game, stops it.
+
+analyzeBatch() spreads up to BATCH_MAX_POSITIONS independent positions over a
+fixed pool of native threads, and done resolves once all are done, in the
+order given. Each position gets options.depth plies, or options.timeMs
+milliseconds of deepening (up to depth, ENGINE_MAX_DEPTH by default). An
+evaluation is { fen, move, uci, score, depth, nodes, cached }, or { fen, error }
+for a position that cannot be searched; one bad position does not fail the
+batch. stop() ends the positions being searched and skips the queued ones,
+which then answer with an error, so a batch nobody waits for frees the pool.
+
+Engine moves and batch positions go through an AnalysisCache keyed by
+position and budget, shared by every session. Evaluations say whether they
+were `cached`. Only searches that reached their full depth are cached, so a
+time budget cut short under load is not served to later callers. Positions
+close enough to the fifty-move rule for the search to reach it are never
+cached, since the key ignores the halfmove clock.
+
+saveSessions() snapshots every game off the event loop (see
+session_snapshot.hpp): its starting FEN and the moves played from it, so a
+restored game keeps its history for threefold repetition.
+*/
+
+constexpr int ENGINE_DEFAULT_DEPTH = 3;
+constexpr int ENGINE_MAX_DEPTH = 4;
+constexpr int ENGINE_MAX_TIME_MS = 2000;
+constexpr int ANALYSIS_DEFAULT_DEPTH = ENGINE_MAX_DEPTH;
+constexpr std::size_t ANALYSES_PER_THREAD = 4;
+constexpr std::size_t ENGINE_MOVES_PER_THREAD = 4;
+constexpr std::size_t BATCH_MAX_POSITIONS = 256;
+
+SessionRegistry<Game> sessions;
+AnalysisCache analysisCache;
+
+// Marks snapshot files of this addon's games, see session_snapshot.hpp
+constexpr char SNAPSHOT_MAGIC[8] = {'J', 'C', 'O', 'S', 'E', 'S', '2', '1'};
+
+struct SearchOptions {
+  int depth = ENGINE_DEFAULT_DEPTH;
+  bool structural = false;
+  int timeMs = ENGINE_MAX_TIME_MS;
+};
+
+struct GameState {
+  std::string fen;
+  std::string status;
+  std::string winner;  // empty while ongoing
+  bool whiteToMove = true;
+};
+
+struct EngineResult {
+  GameState state;
+  std::optional<std::string> san;
+  std::optional<std::string> uci;
+};
+
+std::string StatusName(GameStatus status) {
+  switch (status) {
+    case GameStatus::Ongoing: return "ongoing";
+    case GameStatus::Checkmate: return "checkmate";
+    case GameStatus::Stalemate: return "stalemate";
+    case GameStatus::FiftyMoveRule: return "fifty-move rule";
+    case GameStatus::ThreefoldRepetition: return "threefold repetition";
+    default: return "unknown";
+  }
+}
+
+GameState StateOf(const Game& game) {
+  GameState state;
+  state.fen = game.fen();
+  state.status = StatusName(game.status());
+  switch (game.winner()) {
+    case GameWinner::White: state.winner = "white"; break;
+    case GameWinner::Black: state.winner = "black"; break;
+    case GameWinner::Draw: state.winner = "draw"; break;
+    default: break;
+  }
+  state.whiteToMove = game.board().is_white_to_move();
+  return state;
+}
+
+// Play `text` (SAN or UCI) for the side to move. Throws std::runtime_error if it is not legal.
+void PlayHumanMove(Game& game, const std::string& text) {
+  if (game.status() != GameStatus::Ongoing) throw std::runtime_error("The game is over");
+  std::optional<Move> move = from_algebraic_notation(game.board(), text);
+  if (!move.has_value()) {
+    std::optional<Move> coordinate = uci::parse_move(game.board(), text);
+    if (coordinate.has_value()) move.emplace(coordinate.value());
+  }
+  if (!move.has_value() || game.verify_and_move(move.value()) != 0) {
+    throw std::runtime_error("Illegal move: " + text);
+  }
+}
+
+struct SearchResult {
+  Move move;
+  double score;  // for the side to move
+  bool scored;  // false when the move came from a book or tablebase
+  int depth;
+  uint64_t nodes;
+  bool cached;
+};
+
+// Best move for the side to move of an ongoing position, from the cache or a search with `oracle`.
+// `control` can stop the search from another thread.
+SearchResult Search(const Board& board, int halfmoveClock, const SearchOptions& options, const Oracle& oracle,
+                    SearchControl& control) {
+  const AnalysisKey key{board.get_hash(), options.depth, options.timeMs, options.structural};
+  const bool cacheable = halfmoveClock + options.depth < 100;
+  if (cacheable) {
+    std::optional<CachedAnalysis> hit = analysisCache.find(key);
+    if (hit.has_value() && hit->depth >= options.depth) {
+      // Another position with the same 64-bit hash is unlikely but not detected;
+      // a stored move that is not legal here is only searched like a miss
+      std::optional<Move> move = book::decode_move(hit->move, board);
+      if (move.has_value() && Lawyer::instance().legal(board, move.value())) {
+        return SearchResult{move.value(), hit->score, hit->scored, hit->depth, 0, true};
+      }
+    }
+  }
+
+  DFS agent(oracle, board.is_white_to_move());
+  agent.set_max_depth(options.depth);
+  control.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.timeMs);
+  double score = 0.0;
+  bool scored = false;
+  control.on_iteration = [&score, &scored](const Iteration& iteration) {
+    score = iteration.score;
+    scored = true;
+  };
+  const Move move = agent.explore(board, halfmoveClock, control);
+  SearchResult result{move, score, scored, control.depth, control.nodes, false};
+  // How deep a time budget gets depends on the load, so only complete searches are kept
+  if (cacheable && result.depth >= options.depth) {
+    analysisCache.insert(key, {book::encode_move(move), score, scored, result.depth});
+  }
+  return result;
+}
+
+// Play `humanMove` if given, then search for the side to move and play the result.
+// The session is only locked to copy the position and to play the move, not
+// during the search, so its game can be read meanwhile. Throws if the game
+// moved on while the engine searched.
+EngineResult PlayEngineMove(Session<Game>& session, const std::optional<std::string>& humanMove,
+                            const SearchOptions& options) {
+  EngineResult result;
+  std::optional<Board> board;
+  int halfmoveClock = 0;
+  std::size_t plies = 0;
+  {
+    std::lock_guard<std::mutex> lock(session.mutex);
+    if (humanMove.has_value()) PlayHumanMove(session.game, humanMove.value());
+    if (session.game.status() != GameStatus::Ongoing) {
+      result.state = StateOf(session.game);
+      return result;
+    }
+    board.emplace(session.game.board());
+    halfmoveClock = session.game.get_halfmove_clock();
+    plies = session.game.moves().size();
+  }
+
+  const Oracle oracle = options.structural ? make_structural_oracle() : make_material_oracle();
+  SearchControl control;
+  const Move move = Search(board.value(), halfmoveClock, options, oracle, control).move;
+
+  std::lock_guard<std::mutex> lock(session.mutex);
+  Game& game = session.game;
+  if (game.moves().size() != plies || game.board().get_hash() != board->get_hash()) {
+    throw std::runtime_error("The game changed while the engine was thinking");
+  }
+  result.san = to_algebraic_notation(move, game.board(), SanSuffix::Check);
+  result.uci = uci::move_to_string(move);
+  if (game.verify_and_move(move) != 0) throw std::runtime_error("The engine chose an illegal move");
+  result.state = StateOf(game);
+  return result;
+}
+
+Napi::Object ToObject(Napi::Env env, const GameState& state) {
+  Napi::Object object = Napi::Object::New(env);
+  object.Set("fen", state.fen);
+  object.Set("status", state.status);
+  object.Set("winner", state.winner.empty() ? env.Null() : Napi::String::New(env, state.winner));
+  object.Set("toMove", state.whiteToMove ? "white" : "black");
+  return object;
+}
+
+Napi::Object ToObject(Napi::Env env, const EngineResult& result) {
+  Napi::Object object = ToObject(env, result.state);
+  if (result.san.has_value()) object.Set("move", result.san.value());
+  if (result.uci.has_value()) object.Set("uci", result.uci.value());
+  return object;
+}
+
+SearchOptions ReadSearchOptions(const Napi::Value& value, int depth = ENGINE_DEFAULT_DEPTH) {
+  SearchOptions options;
+  options.depth = depth;
+  if (!value.IsObject()) return options;
+  Napi::Object object = value.As<Napi::Object>();
+  if (object.Get("depth").IsNumber()) {
+    options.depth = std::clamp((int) object.Get("depth").ToNumber().Int32Value(), 1, ENGINE_MAX_DEPTH);
+  }
+  if (object.Get("evaluation").IsString()) {
+    options.structural = (std::string) object.Get("evaluation").ToString() == "structural";
+  }
+  if (object.Get("timeMs").IsNumber()) {
+    options.timeMs = std::clamp((int) object.Get("timeMs").ToNumber().Int32Value(), 1, ENGINE_MAX_TIME_MS);
+    if (!object.Get("depth").IsNumber()) options.depth = ENGINE_MAX_DEPTH;  // the clock decides how deep
+  }
+  return options;
+}
+
+Napi::Value ThrowError(Napi::Env env, const std::string& message) {
+  Napi::Error::New(env, message).ThrowAsJavaScriptException();
+  return env.Undefined();
+}
+
+// Engine moves are searched here, not on libuv's thread pool, so they cannot hold up
+// the legacy addon's moves, snapshots or file system work queued there
+ThreadPool& EnginePool() {
+  static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+  return pool;
+}
+std::atomic<std::size_t> engineMovesRunning{0};  // queued or searching
+
+// An engineMove() or play() call: optionally the human's move, then the engine's reply.
+// Owned by its thread-safe function, which the search releases once done.
+struct EngineRequest {
+  EngineRequest(Napi::Env env, std::string id, std::optional<std::string> humanMove, SearchOptions options)
+    : id(std::move(id)), humanMove(std::move(humanMove)), options(options),
+      done(Napi::Promise::Deferred::New(env)) {}
+
+  std::string id;
+  std::optional<std::string> humanMove;
+  SearchOptions options;
+  Napi::Promise::Deferred done;
+  Napi::ThreadSafeFunction finished;  // never called, its finalizer settles `done`
+
+  // Written on the pool thread, read by the finalizer once it has been released
+  EngineResult result;
+  std::string error;
+};
+
+// Runs on an EnginePool() thread
+void RunEngineRequest(EngineRequest* request) {
+  try {
+    std::shared_ptr<Session<Game>> session = sessions.acquire(request->id);
+    request->result = PlayEngineMove(*session, request->humanMove, request->options);
+  } catch (const std::exception& e) {
+    request->error = e.what();
+  }
+  engineMovesRunning--;
+  request->finished.Release();
+}
+
+Napi::Value QueueEngineRequest(Napi::Env env, std::string id, std::optional<std::string> humanMove,
+                               SearchOptions options) {
+  if (engineMovesRunning.fetch_add(1) >= ENGINE_MOVES_PER_THREAD * EnginePool().size()) {
+    engineMovesRunning--;
+    Napi::Promise::Deferred refused = Napi::Promise::Deferred::New(env);
+    refused.Reject(Napi::Error::New(env, "Too many engine moves waiting, try again later").Value());
+    return refused.Promise();
+  }
+  EngineRequest* request = new EngineRequest(env, std::move(id), std::move(humanMove), options);
+  Napi::Promise promise = request->done.Promise();
+  request->finished = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+                                                    "chess2 engine move", 0, 1, request,
+                                                    [](Napi::Env env, EngineRequest* request) {
+    if (!request->error.empty()) {
+      request->done.Reject(Napi::Error::New(env, request->error).Value());
+    } else {
+      request->done.Resolve(ToObject(env, request->result));
+    }
+    delete request;
+  });
+  EnginePool().submit([request] { RunEngineRequest(request); });
+  return promise;
+}
+
+// One finished depth of an analysis, on its way to the event loop
+struct AnalysisUpdate {
+  int depth;
+  double score;
+  std::vector<std::string> pv;
+  uint64_t nodes;
+  int64_t ms;
+};
+
+// A running analysis. Owned by its thread-safe function, and deleted by its finalizer.
+struct Analysis {
+  Analysis(Napi::Env env, std::string id, const Board& board, int halfmoveClock, SearchOptions options)
+    : id(std::move(id)), board(board), halfmoveClock(halfmoveClock), options(options),
+      control(std::make_shared<SearchControl>()), done(Napi::Promise::Deferred::New(env)) {}
+
+  std::string id;
+  Board board;
+  int halfmoveClock;
+  SearchOptions options;
+  std::shared_ptr<SearchControl> control;
+  Napi::ThreadSafeFunction updates;
+  Napi::Promise::Deferred done;
+
+  // Written by `thread`, read by the finalizer once it has been joined
+  std::optional<std::string> san;
+  std::optional<std::string> uci;
+  int depth = 0;
+  std::string error;
+};
+
+// Analyses are searched here
+ThreadPool& AnalysisPool() {
+  static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+  return pool;
+}
+std::atomic<std::size_t> analysesRunning{0};  // queued or searching
+
+// The analysis running for each session, if any
+std::mutex analysesMutex;
+std::unordered_map<std::string, std::shared_ptr<SearchControl>> analyses;
+
+void StopAnalysis(const std::string& id) {
+  std::lock_guard<std::mutex> lock(analysesMutex);
+  auto found = analyses.find(id);
+  if (found == analyses.end()) return;
+  found->second->stop = true;
+  analyses.erase(found);
+}
+
+Napi::Object ToObject(Napi::Env env, const AnalysisUpdate& update) {
+  Napi::Object object = Napi::Object::New(env);
+  object.Set("depth", update.depth);
+  object.Set("score", update.score);
+  Napi::Array pv = Napi::Array::New(env, update.pv.size());
+  for (size_t i = 0; i < update.pv.size(); ++i) pv.Set((uint32_t) i, update.pv[i]);
+  object.Set("pv", pv);
+  object.Set("nodes", (double) update.nodes);
+  object.Set("nps", (double) (update.ms > 0 ? update.nodes * 1000 / update.ms : update.nodes));
+  object.Set("timeMs", (double) update.ms);
+  return object;
+}
+
+// Runs on an AnalysisPool() thread
+void RunAnalysis(Analysis* analysis) {
+  const auto start = std::chrono::steady_clock::now();
+  analysis->control->on_iteration = [analysis, start](const Iteration& iteration) {
+    AnalysisUpdate* update = new AnalysisUpdate{iteration.depth, iteration.score, {}, iteration.nodes,
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()};
+    for (const Move& move : iteration.pv) update->pv.push_back(uci::move_to_string(move));
+    const napi_status status = analysis->updates.BlockingCall(update,
+      [](Napi::Env env, Napi::Function onUpdate, AnalysisUpdate* update) {
+        if (env != nullptr && onUpdate != nullptr) onUpdate.Call({ToObject(env, *update)});
+        delete update;
+      });
+    if (status != napi_ok) delete update;
+  };
+  analysis->control->deadline = start + std::chrono::milliseconds(analysis->options.timeMs);
+  try {
+    DFS agent(analysis->options.structural ? make_structural_oracle() : make_material_oracle(),
+              analysis->board.is_white_to_move());
+    agent.set_max_depth(analysis->options.depth);
+    const Move move = agent.explore(analysis->board, analysis->halfmoveClock, *analysis->control);
+    analysis->san = to_algebraic_notation(move, analysis->board, SanSuffix::Check);
+    analysis->uci = uci::move_to_string(move);
+  } catch (const std::exception& e) {
+    if (!analysis->control->stop) analysis->error = e.what();  // else stopped before depth 1
+  }
+  analysis->depth = analysis->control->depth;
+  analysesRunning--;
+  analysis->updates.Release();
+}
+
+// Runs on the event loop once the analysis has released its function
+void FinishAnalysis(Napi::Env env, Analysis* analysis) {
+  {
+    std::lock_guard<std::mutex> lock(analysesMutex);
+    auto found = analyses.find(analysis->id);
+    if (found != analyses.end() && found->second == analysis->control) analyses.erase(found);
+  }
+  if (!analysis->error.empty()) {
+    analysis->done.Reject(Napi::Error::New(env, analysis->error).Value());
+  } else {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("move", analysis->san.has_value() ? Napi::String::New(env, analysis->san.value()) : env.Null());
+    result.Set("uci", analysis->uci.has_value() ? Napi::String::New(env, analysis->uci.value()) : env.Null());
+    result.Set("depth", analysis->depth);
+    result.Set("stopped", (bool) analysis->control->stop);
+    analysis->done.Resolve(result);
+  }
+  delete analysis;
+}
+
+Napi::Value Analyze(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3 || !info[2].IsFunction()) return ThrowError(env, "analyze needs an onUpdate callback");
+  const std::string id = info[0].ToString();
+  StopAnalysis(id);
+  if (analysesRunning.fetch_add(1) >= ANALYSES_PER_THREAD * AnalysisPool().size()) {
+    analysesRunning--;
+    return ThrowError(env, "Too many analyses running, try again later");
+  }
+  Analysis* analysis;
+  try {
+    std::shared_ptr<Session<Game>> session = sessions.acquire(id);
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (session->game.status() != GameStatus::Ongoing) throw std::runtime_error("The game is over");
+    analysis = new Analysis(env, id, session->game.board(), session->game.get_halfmove_clock(),
+                            ReadSearchOptions(info[1], ANALYSIS_DEFAULT_DEPTH));
+  } catch (const std::exception& e) {
+    analysesRunning--;
+    return ThrowError(env, e.what());
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(analysesMutex);
+    analyses[id] = analysis->control;
+  }
+  analysis->updates = Napi::ThreadSafeFunction::New(env, info[2].As<Napi::Function>(), "chess2 analysis", 0, 1,
+                                                    analysis, [](Napi::Env env, Analysis* analysis) {
+                                                      FinishAnalysis(env, analysis);
+                                                    });
+  AnalysisPool().submit([analysis] { RunAnalysis(analysis); });
+
+  std::shared_ptr<SearchControl> control = analysis->control;
+  Napi::Object handle = Napi::Object::New(env);
+  handle.Set("stop", Napi::Function::New(env, [control](const Napi::CallbackInfo&) { control->stop = true; }));
+  handle.Set("done", analysis->done.Promise());
+  return handle;
+}
+
+// Positions of analyzeBatch() are searched here
+ThreadPool& BatchPool() {
+  static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+  return pool;
+}
+
+// Oracles are kept per pool thread, so structural ones keep their pawn hash between positions
+const Oracle& BatchOracle(bool structural) {
+  thread_local const Oracle material = make_material_oracle();
+  thread_local const Oracle structuralOracle = make_structural_oracle();
+  return structural ? structuralOracle : material;
+}
+
+struct Evaluation {
+  std::string fen;
+  std::string san;
+  std::string uci;
+  double score = 0.0;  // for the side to move
+  bool scored = false;  // false when the move came from a book or tablebase
+  int depth = 0;
+  uint64_t nodes = 0;
+  bool cached = false;
+  std::string error;  // set when the position could not be searched
+};
+
+Evaluation EvaluatePosition(const std::string& text, const SearchOptions& options, SearchControl& control) {
+  Evaluation evaluation;
+  evaluation.fen = text;
+  try {
+    int halfmoveClock = 0;
+    int fullmoveNumber = 1;
+    const Board board = fen::parse(text, halfmoveClock, fullmoveNumber);
+    if (Lawyer::instance().game_status(board, {}, halfmoveClock) != GameStatus::Ongoing) {
+      throw std::runtime_error("The game is over");
+    }
+    const SearchResult result = Search(board, halfmoveClock, options, BatchOracle(options.structural), control);
+    evaluation.san = to_algebraic_notation(result.move, board, SanSuffix::Check);
+    evaluation.uci = uci::move_to_string(result.move);
+    evaluation.score = result.score;
+    evaluation.scored = result.scored;
+    evaluation.depth = result.depth;
+    evaluation.nodes = result.nodes;
+    evaluation.cached = result.cached;
+  } catch (const std::exception& e) {
+    evaluation.error = e.what();
+  }
+  return evaluation;
+}
+
+Napi::Object ToObject(Napi::Env env, const Evaluation& evaluation) {
+  Napi::Object object = Napi::Object::New(env);
+  object.Set("fen", evaluation.fen);
+  if (!evaluation.error.empty()) {
+    object.Set("error", evaluation.error);
+    return object;
+  }
+  object.Set("move", evaluation.san);
+  object.Set("uci", evaluation.uci);
+  object.Set("score", evaluation.scored ? Napi::Number::New(env, evaluation.score) : env.Null());
+  object.Set("depth", evaluation.depth);
+  object.Set("nodes", (double) evaluation.nodes);
+  object.Set("cached", evaluation.cached);
+  return object;
+}
+
+// Stops an analyzeBatch() call: shared by its positions and the stop() handed to JavaScript
+struct BatchStop {
+  std::mutex mutex;
+  bool stopped = false;
+  std::vector<SearchControl*> searching;  // controls of the positions being searched
+
+  void stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+    for (SearchControl* control : searching) control->stop = true;
+  }
+
+  // Register a position's search. False if the batch was stopped before it started.
+  bool start(SearchControl* control) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopped) return false;
+    searching.push_back(control);
+    return true;
+  }
+
+  void finish(SearchControl* control) {
+    std::lock_guard<std::mutex> lock(mutex);
+    searching.erase(std::find(searching.begin(), searching.end(), control));
+  }
+};
+
+// An analyzeBatch() call. Owned by its thread-safe function, which the last position to finish releases.
+struct Batch {
+  Batch(Napi::Env env, std::vector<std::string> fens, SearchOptions options)
+    : fens(std::move(fens)), options(options), evaluations(this->fens.size()),
+      remaining(this->fens.size()), stop(std::make_shared<BatchStop>()),
+      done(Napi::Promise::Deferred::New(env)) {}
+
+  std::vector<std::string> fens;
+  SearchOptions options;
+  std::vector<Evaluation> evaluations;  // each written by one pool thread only
+  std::atomic<size_t> remaining;
+  std::shared_ptr<BatchStop> stop;
+  Napi::Promise::Deferred done;
+  Napi::ThreadSafeFunction finished;  // never called, its finalizer resolves `done`
+};
+
+// Runs on a BatchPool() thread
+void EvaluateBatchPosition(Batch* batch, size_t i) {
+  SearchControl control;
+  if (batch->stop->start(&control)) {
+    batch->evaluations[i] = EvaluatePosition(batch->fens[i], batch->options, control);
+    batch->stop->finish(&control);
+  } else {
+    batch->evaluations[i].fen = batch->fens[i];
+    batch->evaluations[i].error = "The batch was stopped";
+  }
+  if (batch->remaining.fetch_sub(1) == 1) batch->finished.Release();
+}
+
+Napi::Value AnalyzeBatch(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!info[0].IsArray()) return ThrowError(env, "analyzeBatch needs an array of FEN strings");
+  Napi::Array positions = info[0].As<Napi::Array>();
+  if (positions.Length() > BATCH_MAX_POSITIONS) {
+    return ThrowError(env, "analyzeBatch takes at most " + std::to_string(BATCH_MAX_POSITIONS) + " positions");
+  }
+  std::vector<std::string> fens;
+  fens.reserve(positions.Length());
+  for (uint32_t i = 0; i < positions.Length(); ++i) fens.push_back(positions.Get(i).ToString());
+  SearchOptions options = ReadSearchOptions(info[1]);
+
+  Batch* batch = new Batch(env, std::move(fens), options);
+  std::shared_ptr<BatchStop> stop = batch->stop;
+  Napi::Object handle = Napi::Object::New(env);
+  handle.Set("stop", Napi::Function::New(env, [stop](const Napi::CallbackInfo&) { stop->stop(); }));
+  handle.Set("done", batch->done.Promise());
+  if (batch->fens.empty()) {
+    batch->done.Resolve(Napi::Array::New(env));
+    delete batch;
+    return handle;
+  }
+  batch->finished = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+                                                  "chess2 batch", 0, 1, batch, [](Napi::Env env, Batch* batch) {
+    Napi::Array results = Napi::Array::New(env, batch->evaluations.size());
+    for (size_t i = 0; i < batch->evaluations.size(); ++i) {
+      results.Set((uint32_t) i, ToObject(env, batch->evaluations[i]));
+    }
+    batch->done.Resolve(results);
+    delete batch;
+  });
+  for (size_t i = 0; i < batch->fens.size(); ++i) {
+    BatchPool().submit([batch, i] { EvaluateBatchPosition(batch, i); });
+  }
+  return handle;
+}
+
+Napi::Object CacheStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  const AnalysisCacheStats stats = analysisCache.stats();
+  Napi::Object object = Napi::Object::New(env);
+  object.Set("entries", (double) stats.entries);
+  object.Set("capacity", (double) stats.capacity);
+  object.Set("hits", (double) stats.hits);
+  object.Set("misses", (double) stats.misses);
+  object.Set("evictions", (double) stats.evictions);
+  return object;
+}
+
+void SetCacheSize(const Napi::CallbackInfo& info) {
+  const double entries = info[0].ToNumber().DoubleValue();
+  analysisCache.setCapacity(entries < 0 ? 0 : (std::size_t) entries);
+}
+
+void ClearCache(const Napi::CallbackInfo&) {
+  analysisCache.clear();
+}
+
+Napi::Value SaveCache(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  try {
+    return Napi::Number::New(env, (double) analysisCache.save(info[0].ToString()));
+  } catch (const std::exception& e) {
+    return ThrowError(env, e.what());
+  }
+}
+
+Napi::Value LoadCache(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  try {
+    return Napi::Number::New(env, (double) analysisCache.load(info[0].ToString()));
+  } catch (const std::exception& e) {
+    return ThrowError(env, e.what());
+  }
+}
+
+// A game in a snapshot: its starting FEN, a newline, then book::encode_move() of each move played
+void SaveGame(const Game& game, std::string& out) {
+  out += game.starting_fen();
+  out += '\n';
+  for (const Move& move : game.moves()) {
+    const uint16_t code = book::encode_move(move);
+    out.append(reinterpret_cast<const char*>(&code), sizeof(code));
+  }
+}
+
+// Throws, leaving `game` untouched, if the saved game does not replay
+void RestoreGame(Game& game, const char* data, std::size_t size) {
+  const char* newline = static_cast<const char*>(std::memchr(data, '\n', size));
+  if (newline == nullptr) throw std::runtime_error("Saved game has no starting position");
+  const std::size_t fenSize = newline - data;
+  if ((size - fenSize - 1) % sizeof(uint16_t) != 0) throw std::runtime_error("Saved game has a partial move");
+  Game restored;
+  restored.load_fen(std::string(data, fenSize));
+  for (std::size_t at = fenSize + 1; at < size; at += sizeof(uint16_t)) {
+    uint16_t code;
+    std::memcpy(&code, data + at, sizeof(code));
+    std::optional<Move> move = book::decode_move(code, restored.board());
+    if (!move.has_value() || restored.verify_and_move(move.value()) != 0) {
+      throw std::runtime_error("Saved game has an illegal move");
+    }
+  }
+  game = std::move(restored);
+}
+
+// Writes a snapshot of every session off the event loop, settling a promise with the session count
+class SaveSessionsWorker : public Napi::AsyncWorker {
+public:
+  SaveSessionsWorker(Napi::Env env, std::string path)
+    : Napi::AsyncWorker(env), path(std::move(path)), deferred(Napi::Promise::Deferred::New(env)) {}
+
+  Napi::Promise Promise() { return deferred.Promise(); }
+
+  void Execute() override {
+    try {
+      count = saveSessions(sessions, path, SNAPSHOT_MAGIC, SaveGame);
+    } catch (const std::exception& e) {
+      SetError(e.what());
+    }
+  }
+
+  void OnOK() override {
+    deferred.Resolve(Napi::Number::New(Env(), (double) count));
+  }
+
+  void OnError(const Napi::Error& e) override {
+    deferred.Reject(e.Value());
+  }
+
+private:
+  std::string path;
+  std::size_t count = 0;
+  Napi::Promise::Deferred deferred;
+};
+
+Napi::Value SaveSessions(const Napi::CallbackInfo& info) {
+  SaveSessionsWorker* worker = new SaveSessionsWorker(info.Env(), info[0].ToString());
+  Napi::Promise promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
+
+Napi::Value LoadSessions(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  try {
+    return Napi::Number::New(env, (double) loadSessions(sessions, info[0].ToString(), SNAPSHOT_MAGIC, RestoreGame));
+  } catch (const std::exception& e) {
+    return ThrowError(env, e.what());
+  }
+}
+
+Napi::Value NewGame(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  StopAnalysis(info[0].ToString());
+  try {
+    std::shared_ptr<Session<Game>> session = sessions.acquire(info[0].ToString());
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (info.Length() >= 2 && info[1].IsString()) {
+      session->game.load_fen(info[1].As<Napi::String>());
+    } else {
+      session->game.reset();
+    }
+    return ToObject(env, StateOf(session->game));
+  } catch (const std::exception& e) {
+    return ThrowError(env, e.what());
+  }
+}
+
+Napi::Value State(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  try {
+    std::shared_ptr<Session<Game>> session = sessions.acquire(info[0].ToString());
+    std::lock_guard<std::mutex> lock(session->mutex);
+    return ToObject(env, StateOf(session->game));
+  } catch (const std::exception& e) {
+    return ThrowError(env, e.what());
+  }
+}
+
+Napi::Value LegalMoves(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  try {
+    std::shared_ptr<Session<Game>> session = sessions.acquire(info[0].ToString());
+    std::lock_guard<std::mutex> lock(session->mutex);
+    const Board& board = session->game.board();
+    Napi::Array moves = Napi::Array::New(env);
+    if (session->game.status() != GameStatus::Ongoing) return moves;
+    const std::vector<Move> legal = Lawyer::instance().legal_moves(board);
+    for (size_t i = 0; i < legal.size(); ++i) {
+      moves.Set((uint32_t) i, to_algebraic_notation(legal[i], board, legal, SanSuffix::Check));
+    }
+    return moves;
+  } catch (const std::exception& e) {
+    return ThrowError(env, e.what());
+  }
+}
+
+Napi::Value HumanMove(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  StopAnalysis(info[0].ToString());
+  try {
+    std::shared_ptr<Session<Game>> session = sessions.acquire(info[0].ToString());
+    std::lock_guard<std::mutex> lock(session->mutex);
+    PlayHumanMove(session->game, info[1].ToString());
+    return ToObject(env, StateOf(session->game));
+  } catch (const std::exception& e) {
+    return ThrowError(env, e.what());
+  }
+}
+
+Napi::Value EngineMove(const Napi::CallbackInfo& info) {
+  StopAnalysis(info[0].ToString());
+  return QueueEngineRequest(info.Env(), info[0].ToString(), std::nullopt, ReadSearchOptions(info[1]));
+}
+
+Napi::Value Play(const Napi::CallbackInfo& info) {
+  StopAnalysis(info[0].ToString());
+  return QueueEngineRequest(info.Env(), info[0].ToString(), (std::string) info[1].ToString(),
+                            ReadSearchOptions(info[2]));
+}
+
+Napi::Boolean EndSession(const Napi::CallbackInfo& info) {
+  StopAnalysis(info[0].ToString());
+  return Napi::Boolean::New(info.Env(), sessions.erase(info[0].ToString()));
+}
+
+void SetMaxSessions(const Napi::CallbackInfo& info) {
+  const double cap = info[0].ToNumber().DoubleValue();
+  sessions.setMaxSessions(cap < 1 ? 1 : (std::size_t) cap);
+}
+
+Napi::Number SessionCount(const Napi::CallbackInfo& info) {
+  return Napi::Number::New(info.Env(), (double) sessions.size());
+}
+
+Napi::Object Init(Napi::Env env, Napi::Object exports) {
+  exports.Set("newGame", Napi::Function::New(env, NewGame));
+  exports.Set("state", Napi::Function::New(env, State));
+  exports.Set("legalMoves", Napi::Function::New(env, LegalMoves));
+  exports.Set("move", Napi::Function::New(env, HumanMove));
+  exports.Set("engineMove", Napi::Function::New(env, EngineMove));
+  exports.Set("play", Napi::Function::New(env, Play));
+  exports.Set("analyze", Napi::Function::New(env, Analyze));
+  exports.Set("analyzeBatch", Napi::Function::New(env, AnalyzeBatch));
+  exports.Set("cacheStats", Napi::Function::New(env, CacheStats));
+  exports.Set("setCacheSize", Napi::Function::New(env, SetCacheSize));
+  exports.Set("clearCache", Napi::Function::New(env, ClearCache));
+  exports.Set("saveCache", Napi::Function::New(env, SaveCache));
+  exports.Set("loadCache", Napi::Function::New(env, LoadCache));
+  exports.Set("saveSessions", Napi::Function::New(env, SaveSessions));
+  exports.Set("loadSessions", Napi::Function::New(env, LoadSessions));
+  exports.Set("endSession", Napi::Function::New(env, EndSession));
+  exports.Set("setMaxSessions", Napi::Function::New(env, SetMaxSessions));
+  exports.Set("sessionCount", Napi::Function::New(env, SessionCount));
+  return exports;
+}
+
+NODE_API_MODULE(chess2, Init)
@@ -1,5 +1,8 @@
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <unordered_set>
@@ -18,6 +21,24 @@ const std::string ZEROTH_MOVE_COMMAND = "__INITIATE_GAME__";
 const std::string QUIT_GAME_COMMAND = "__QUIT_GAME__";
 constexpr char COMMAND_SEPARATOR = ',';
 
+// What a command did, as reported in byte 67 of a board record
+enum class OUTCOME : uint8_t {
+    STARTED,  // ZEROTH_MOVE_COMMAND
+    PLAYED,
+    ILLEGAL,
+    MEANINGLESS,
+    QUIT
+};
+
+// Board records, see Game::writeRecord
+constexpr size_t BOARD_RECORD_SIZE = 72;
+constexpr uint8_t NO_SQUARE = 0xFF;
+
+// Index of a square in a board record: a1 = 0, b1 = 1, ..., h8 = 63
+uint8_t recordIndex(const Square& s) {
+    return 8*(s.rank()-1) + (s.row()-'a');
+}
+
 // TODO better place for this method?
 // move type, player to move, castling side
 // OR
@@ -36,6 +57,9 @@ std::optional<Move> readRawNotation(std::string raw) {
         words.push_back(temp);
     }
     if (words.size() < 3 || words.size() > 4) return {};
+    if (words[0] != "CASTLE" && words.size() != 4) return {};
+    // Squares are a letter and a digit, e.g. "e4"
+    if (words[0] != "CASTLE" && (words[2].size() != 2 || words[3].size() != 2)) return {};
 
     // Castle
     if (words[0] == "CASTLE") {
@@ -103,58 +127,163 @@ class Game {
     // All previous positions, for the 3-time repetition rule
     std::unordered_set<State, FEN> onceRepeatedPositions;
     std::unordered_set<State, FEN> twiceRepeatedPositions;
-    std::vector<Move> allMoves;  // for game history purposes
+    std::vector<Move> allMoves;  // moves played, for game history purposes
     State currPos;
+
+    // Whether a move's squares, if it has any, are all on the board
+    static bool onBoard(const Move& m) {
+        return (!m.start.has_value() || m.start.value().isValid())
+            && (!m.end.has_value() || m.end.value().isValid());
+    }
+
 public:
     Game() : currPos{}, onceRepeatedPositions{}, twiceRepeatedPositions{} {}
 
-    std::string playMove(const std::string& command) {
-        std::stringstream ss;  // output
-        if (command == QUIT) return ss.str();
-        if (command == ZEROTH_MOVE_COMMAND) {
-            ss << currPos << '\n';
-            ss << "Input a move, or type " << QUIT 
-                << " to quit. Player to move: "
-                << currPos.playerToMove() << '\n';
-            return ss.str();
-        }
-        Move* finalMove;
+    // Read and play `command`. If the move is refused, `issue` says why.
+    OUTCOME play(const std::string& command, std::string& issue) {
+        if (command == QUIT) return OUTCOME::QUIT;
+        if (command == ZEROTH_MOVE_COMMAND) return OUTCOME::STARTED;
 
         // Read algebraic notation, e.g. "Nxe4"
-        auto m = currPos.b.readAlgebraicNotation(command,
+        // TODO Qxa1 checked twice for the queen motion
+        std::optional<Move> m = currPos.b.readAlgebraicNotation(command,
             currPos.playerToMove());
-        if (m.has_value()) {
-            // TODO Qxa1 checked twice for the queen motion
-            finalMove = new Move {m.value()};
-        } else {
-
-            // Read raw notation, e.g. "CAPTURE,WHITE,d1,a4"
-            auto move = readRawNotation(command);
-            if (!move.has_value()) {
-                ss << "That move is meaningless. Try again." << '\n';
-                return ss.str();
-            }
-            finalMove = new Move {move.value()};
 
+        // Read raw notation, e.g. "CAPTURE,WHITE,d1,a4", which names its
+        // squares outright: off-board ones make it meaningless
+        if (!m.has_value()) {
+            m = readRawNotation(command);
+            if (m.has_value() && !onBoard(m.value())) return OUTCOME::MEANINGLESS;
         }
+        if (!m.has_value()) return OUTCOME::MEANINGLESS;
 
         // Perform the given move
-        try {currPos.move(*finalMove);}
-        catch (std::invalid_argument stdia) {
-            ss << "Can't move there. ISSUE: "
-                        << stdia.what() << '\n';
+        OUTCOME outcome = OUTCOME::PLAYED;
+        try {
+            currPos.move(m.value());
+            allMoves.push_back(m.value());
+        } catch (std::invalid_argument stdia) {
+            issue = stdia.what();
+            outcome = OUTCOME::ILLEGAL;
+        }
+        return outcome;
+    }
+
+    std::string playMove(const std::string& command) {
+        std::stringstream ss;  // output
+        std::string issue;
+        OUTCOME outcome = play(command, issue);
+        if (outcome == OUTCOME::QUIT) return ss.str();
+        if (outcome == OUTCOME::MEANINGLESS) {
+            ss << "That move is meaningless. Try again." << '\n';
+            return ss.str();
+        }
+        if (outcome == OUTCOME::ILLEGAL) {
+            ss << "Can't move there. ISSUE: " << issue << '\n';
         }
-        allMoves.push_back(*finalMove);
-        delete finalMove;
-        ss << currPos << std::endl;
+        ss << currPos << '\n';
 
         // Prepare for new move.
         ss << "Input a move, or type " << QUIT 
-                << " to quit. Player to move: "
-                << currPos.playerToMove() << '\n';
+            << " to quit. Player to move: "
+            << currPos.playerToMove() << '\n';
 
         return ss.str();  // to be printed to terminal
     }
+
+    /* Write the current position into `out`, BOARD_RECORD_SIZE bytes, with
+       no text formatting. `outcome` is what the last command did.
+        0-63   squares a1, b1, ..., h8 as FEN letters, '.' if empty
+        64     player to move: 0 white, 1 black
+        65     castling availability: 1 white kingside, 2 white queenside,
+               4 black kingside, 8 black queenside
+        66     en passant square, or NO_SQUARE
+        67     outcome
+        68-69  start and end squares of the last move played (the king's
+               for castling), or NO_SQUARE before the first move
+        70     halfmoves, capped at 255
+        71     fullmoves, capped at 255
+       See record() for what follows an ILLEGAL outcome. */
+    void writeRecord(OUTCOME outcome, uint8_t* out) const {
+        char board[8][8];
+        BoardToArray BTA;
+        BTA.print(currPos.b, board);
+        for (int row=0; row<8; row++) {
+            for (int col=0; col<8; col++) out[8*col + row] = board[row][col];
+        }
+
+        out[64] = currPos.whiteToMove ? 0 : 1;
+        out[65] = (currPos.WKCastle ? 1 : 0) | (currPos.WQCastle ? 2 : 0)
+            | (currPos.BKCastle ? 4 : 0) | (currPos.BQCastle ? 8 : 0);
+        out[66] = currPos.enPassantSquare.has_value()
+            ? recordIndex(currPos.enPassantSquare.value()) : NO_SQUARE;
+        out[67] = static_cast<uint8_t>(outcome);
+        out[68] = NO_SQUARE;
+        out[69] = NO_SQUARE;
+        if (!allMoves.empty()) {
+            const Move& m = allMoves.back();
+            if (m.type == MOVE::CASTLE) {
+                const int rank = (m.player == PLAYERTOMOVE::WHITE) ? 1 : 8;
+                out[68] = recordIndex({'e', rank});
+                out[69] = recordIndex(
+                    {(m.side.value() == CASTLING::KINGSIDE) ? 'g' : 'c', rank});
+            } else {
+                out[68] = recordIndex(m.start.value());
+                out[69] = recordIndex(m.end.value());
+            }
+        }
+        out[70] = static_cast<uint8_t>(std::min(currPos.halfmoves, 255));
+        out[71] = static_cast<uint8_t>(std::min(currPos.fullmoves, 255));
+    }
+
+    // writeRecord(), followed for an ILLEGAL outcome by `issue` (as from
+    // play()) as text, so the reason a move was refused is not lost
+    std::vector<uint8_t> record(OUTCOME outcome, const std::string& issue) const {
+        std::vector<uint8_t> out(BOARD_RECORD_SIZE);
+        writeRecord(outcome, out.data());
+        if (outcome == OUTCOME::ILLEGAL) out.insert(out.end(), issue.begin(), issue.end());
+        return out;
+    }
+
+    /* Append the moves played to `out`, 3 bytes each: type | player << 2 |
+       castling side << 3, then the start and end squares as record indices
+       (NO_SQUARE for castling). restore() replays them. */
+    void save(std::string& out) const {
+        for (const Move& m : allMoves) {
+            out += static_cast<char>(static_cast<int>(m.type)
+                | (static_cast<int>(m.player) << 2)
+                | (static_cast<int>(m.side.value_or(CASTLING::KINGSIDE)) << 3));
+            out += static_cast<char>(m.start.has_value() ? recordIndex(m.start.value()) : NO_SQUARE);
+            out += static_cast<char>(m.end.has_value() ? recordIndex(m.end.value()) : NO_SQUARE);
+        }
+    }
+
+    // Replace this game by the one save() wrote into `data`.
+    // Throws std::invalid_argument, leaving this game untouched, if it does not replay.
+    void restore(const char* data, size_t size) {
+        if (size % 3 != 0) throw std::invalid_argument{"Saved game has a partial move"};
+        Game restored;
+        for (size_t i = 0; i < size; i += 3) {
+            const uint8_t flags = static_cast<uint8_t>(data[i]);
+            const uint8_t start = static_cast<uint8_t>(data[i+1]);
+            const uint8_t end = static_cast<uint8_t>(data[i+2]);
+            const MOVE type = static_cast<MOVE>(flags & 3);
+            const PLAYERTOMOVE player = (flags & 4) ? PLAYERTOMOVE::BLACK : PLAYERTOMOVE::WHITE;
+            if (type == MOVE::CASTLE) {
+                restored.allMoves.push_back(Move(type, player,
+                    (flags & 8) ? CASTLING::QUEENSIDE : CASTLING::KINGSIDE));
+            } else {
+                if (start >= 64 || end >= 64) {
+                    throw std::invalid_argument{"Saved game has a move off the board"};
+                }
+                restored.allMoves.push_back(Move(type, player,
+                    {static_cast<char>('a' + start % 8), start / 8 + 1},
+                    {static_cast<char>('a' + end % 8), end / 8 + 1}));
+            }
+            restored.currPos.move(restored.allMoves.back());
+        }
+        *this = std::move(restored);
+    }
     
     
     /*void play() {
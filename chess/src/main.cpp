@@ -1,20 +1,201 @@
 #include <napi.h>
+#include <vector>
+#include <cstdint>
 #include <string>
 #include <exception>
+#include <mutex>
 #include "game.hpp"
+#include "session_registry.hpp"
+#include "session_snapshot.hpp"
 
-Game g;
+// Calls without a session id share this session, as the single global game used to
+const std::string DEFAULT_SESSION = "";
+
+SessionRegistry<Game> registry;
+
+// Marks snapshot files of this addon's games, see session_snapshot.hpp
+constexpr char SNAPSHOT_MAGIC[8] = {'J', 'C', 'O', 'S', 'E', 'S', 'S', '1'};
+
+// Play `command` in session `id`. Errors come back as the returned text, like illegal moves do.
+std::string PlayMoveInSession(const std::string& id, const std::string& command) {
+  std::string board;
+  try {
+    std::shared_ptr<Session<Game>> session = registry.acquire(id);
+    std::lock_guard<std::mutex> lock(session->mutex);
+    board += session->game.playMove(command);
+  } catch (const std::exception& e) {
+    board += e.what();
+  }
+  return board;
+}
+
+// Play `command` in session `id` and return the resulting board record (see Game::record).
+// Unlike PlayMoveInSession, session errors are thrown: a record cannot carry them.
+std::vector<uint8_t> PlayMoveRecordInSession(const std::string& id, const std::string& command) {
+  std::shared_ptr<Session<Game>> session = registry.acquire(id);
+  std::lock_guard<std::mutex> lock(session->mutex);
+  std::string issue;
+  const OUTCOME outcome = session->game.play(command, issue);
+  return session->game.record(outcome, issue);
+}
+
+// Arguments are (command) or (sessionId, command)
+void ReadMoveArguments(const Napi::CallbackInfo& info, std::string& id, std::string& command) {
+  if (info.Length() >= 2) {
+    id = (std::string) info[0].ToString();
+    command = (std::string) info[1].ToString();
+  } else {
+    id = DEFAULT_SESSION;
+    command = (std::string) info[0].ToString(); // or Utf8Value();
+  }
+}
 
 Napi::String PlayMove(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
-  std::string command = (std::string) info[0].ToString(); // or Utf8Value();           
+  std::string id, command;
+  ReadMoveArguments(info, id, command);
+  return Napi::String::New(env, PlayMoveInSession(id, command));
+}
+
+// Same as PlayMove, but returns the board record (see Game::record) as a Buffer
+Napi::Value PlayMoveBinary(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  std::string id, command;
+  ReadMoveArguments(info, id, command);
+  std::vector<uint8_t> record;
+  try {
+    record = PlayMoveRecordInSession(id, command);
+  } catch (const std::exception& e) {
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  return Napi::Buffer<uint8_t>::Copy(env, record.data(), record.size());
+}
+
+// Runs the move off the event loop and settles a promise with what PlayMove
+// (or, if `binary`, PlayMoveBinary) returns
+class PlayMoveWorker : public Napi::AsyncWorker {
+public:
+  PlayMoveWorker(Napi::Env env, std::string id, std::string command, bool binary)
+    : Napi::AsyncWorker(env), id(std::move(id)), command(std::move(command)), binary(binary),
+      deferred(Napi::Promise::Deferred::New(env)) {}
+
+  Napi::Promise Promise() { return deferred.Promise(); }
+
+  void Execute() override {
+    if (!binary) {
+      board = PlayMoveInSession(id, command);
+      return;
+    }
+    try {
+      record = PlayMoveRecordInSession(id, command);
+    } catch (const std::exception& e) {
+      SetError(e.what());
+    }
+  }
+
+  void OnOK() override {
+    if (binary) {
+      deferred.Resolve(Napi::Buffer<uint8_t>::Copy(Env(), record.data(), record.size()));
+    } else {
+      deferred.Resolve(Napi::String::New(Env(), board));
+    }
+  }
+
+  void OnError(const Napi::Error& e) override {
+    deferred.Reject(e.Value());
+  }
+
+private:
+  std::string id;
+  std::string command;
+  bool binary;
   std::string board;
+  std::vector<uint8_t> record;
+  Napi::Promise::Deferred deferred;
+};
+
+Napi::Value QueuePlayMove(const Napi::CallbackInfo& info, bool binary) {
+  Napi::Env env = info.Env();
+  std::string id, command;
+  ReadMoveArguments(info, id, command);
+  PlayMoveWorker* worker = new PlayMoveWorker(env, id, command, binary);  // deletes itself once settled
+  Napi::Promise promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
+
+Napi::Value PlayMoveAsync(const Napi::CallbackInfo& info) {
+  return QueuePlayMove(info, false);
+}
+
+Napi::Value PlayMoveBinaryAsync(const Napi::CallbackInfo& info) {
+  return QueuePlayMove(info, true);
+}
+
+Napi::Boolean EndSession(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  return Napi::Boolean::New(env, registry.erase((std::string) info[0].ToString()));
+}
+
+void SetMaxSessions(const Napi::CallbackInfo& info) {
+  const double cap = info[0].ToNumber().DoubleValue();
+  registry.setMaxSessions(cap < 1 ? 1 : (std::size_t) cap);
+}
+
+Napi::Number SessionCount(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  return Napi::Number::New(env, (double) registry.size());
+}
+
+// Writes a snapshot of every session off the event loop, settling a promise with the session count
+class SaveSessionsWorker : public Napi::AsyncWorker {
+public:
+  SaveSessionsWorker(Napi::Env env, std::string path)
+    : Napi::AsyncWorker(env), path(std::move(path)), deferred(Napi::Promise::Deferred::New(env)) {}
+
+  Napi::Promise Promise() { return deferred.Promise(); }
+
+  void Execute() override {
+    try {
+      count = saveSessions(registry, path, SNAPSHOT_MAGIC,
+                           [](const Game& game, std::string& out) { game.save(out); });
+    } catch (const std::exception& e) {
+      SetError(e.what());
+    }
+  }
+
+  void OnOK() override {
+    deferred.Resolve(Napi::Number::New(Env(), (double) count));
+  }
+
+  void OnError(const Napi::Error& e) override {
+    deferred.Reject(e.Value());
+  }
+
+private:
+  std::string path;
+  std::size_t count = 0;
+  Napi::Promise::Deferred deferred;
+};
+
+Napi::Value SaveSessions(const Napi::CallbackInfo& info) {
+  SaveSessionsWorker* worker = new SaveSessionsWorker(info.Env(), info[0].ToString());
+  Napi::Promise promise = worker->Promise();
+  worker->Queue();
+  return promise;
+}
+
+Napi::Value LoadSessions(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
   try {
-    board += g.playMove(command);
+    const std::size_t count = loadSessions(registry, info[0].ToString(), SNAPSHOT_MAGIC,
+      [](Game& game, const char* data, std::size_t size) { game.restore(data, size); });
+    return Napi::Number::New(env, (double) count);
   } catch (const std::exception& e) {
-    board += e.what();
-  }                                                                                                            
-  return Napi::String::New(env, board);
+    Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
 }
 
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
@@ -22,6 +203,38 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     Napi::String::New(env, "playMove"),
     Napi::Function::New(env, PlayMove)
   );
+  exports.Set(
+    Napi::String::New(env, "playMoveAsync"),
+    Napi::Function::New(env, PlayMoveAsync)
+  );
+  exports.Set(
+    Napi::String::New(env, "playMoveBinary"),
+    Napi::Function::New(env, PlayMoveBinary)
+  );
+  exports.Set(
+    Napi::String::New(env, "playMoveBinaryAsync"),
+    Napi::Function::New(env, PlayMoveBinaryAsync)
+  );
+  exports.Set(
+    Napi::String::New(env, "endSession"),
+    Napi::Function::New(env, EndSession)
+  );
+  exports.Set(
+    Napi::String::New(env, "setMaxSessions"),
+    Napi::Function::New(env, SetMaxSessions)
+  );
+  exports.Set(
+    Napi::String::New(env, "sessionCount"),
+    Napi::Function::New(env, SessionCount)
+  );
+  exports.Set(
+    Napi::String::New(env, "saveSessions"),
+    Napi::Function::New(env, SaveSessions)
+  );
+  exports.Set(
+    Napi::String::New(env, "loadSessions"),
+    Napi::Function::New(env, LoadSessions)
+  );
   return exports;
 }
 
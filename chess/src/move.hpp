@@ -67,6 +67,7 @@ public:
     }
 
     friend class State;
+    friend class Game;
 };
 
 #endif  // CHESS_MOVE_H
\ No newline at end of file
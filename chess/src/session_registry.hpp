@@ -0,0 +1,118 @@
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef CHESS_SESSION_REGISTRY_H
+#define CHESS_SESSION_REGISTRY_H
+
+constexpr std::size_t DEFAULT_MAX_SESSIONS = 10000;
+
+// One player's game. Lock `mutex` while using `game`.
+template <typename GameType>
+struct Session {
+    std::mutex mutex;
+    GameType game;
+};
+
+/*
+SessionRegistry Class:
+----------------------
+Games keyed by session id, so every client plays on its own board. GameType
+is the engine's game class, default-constructed for each new session.
+
+Lookups go through a hash map. Sessions are also kept in a list ordered by
+last use, which is how the least recently used idle session is found when a
+new session would exceed the cap. A session is idle when nobody but the
+registry holds it, i.e. no move is being played on it. If every session is
+busy, acquire() throws.
+
+The registry lock only covers the map and the list. Moves are played under
+each session's own lock, so different games never wait for each other.
+*/
+template <typename GameType>
+class SessionRegistry {
+    struct Entry {
+        std::shared_ptr<Session<GameType>> session;
+        std::list<std::string>::iterator recency;  // position in `byRecency`
+    };
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> sessions;
+    std::list<std::string> byRecency;  // most recently used first
+    std::size_t maxSessions;
+
+    // Drop the least recently used idle session. Returns false if all are busy.
+    bool evictOne() {
+        for (auto it = byRecency.rbegin(); it != byRecency.rend(); ++it) {
+            auto found = sessions.find(*it);
+            if (found->second.session.use_count() > 1) continue;
+            byRecency.erase(std::next(it).base());
+            sessions.erase(found);
+            return true;
+        }
+        return false;
+    }
+
+public:
+    explicit SessionRegistry(std::size_t maxSessions = DEFAULT_MAX_SESSIONS)
+        : maxSessions(maxSessions == 0 ? 1 : maxSessions) {}
+
+    // The session called `id`, created if new, and marked as most recently used.
+    std::shared_ptr<Session<GameType>> acquire(const std::string& id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = sessions.find(id);
+        if (found != sessions.end()) {
+            byRecency.splice(byRecency.begin(), byRecency, found->second.recency);
+            return found->second.session;
+        }
+        while (sessions.size() >= maxSessions) {
+            if (!evictOne()) throw std::runtime_error("Too many sessions in play, try again later");
+        }
+        byRecency.push_front(id);
+        auto session = std::make_shared<Session<GameType>>();
+        sessions.emplace(id, Entry{session, byRecency.begin()});
+        return session;
+    }
+
+    // Forget a session. A move being played on it still finishes.
+    bool erase(const std::string& id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = sessions.find(id);
+        if (found == sessions.end()) return false;
+        byRecency.erase(found->second.recency);
+        sessions.erase(found);
+        return true;
+    }
+
+    // Lowering the cap evicts idle sessions until the registry fits, as far as possible.
+    void setMaxSessions(std::size_t cap) {
+        std::lock_guard<std::mutex> lock(mutex);
+        maxSessions = cap == 0 ? 1 : cap;
+        while (sessions.size() > maxSessions && evictOne()) {}
+    }
+
+    // Every session with its id, least recently used first. The sessions are
+    // held weakly, so a listing does not make them look busy to eviction:
+    // lock each one when its turn comes, and skip it if it is gone.
+    std::vector<std::pair<std::string, std::weak_ptr<Session<GameType>>>> list() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::pair<std::string, std::weak_ptr<Session<GameType>>>> all;
+        all.reserve(sessions.size());
+        for (auto it = byRecency.rbegin(); it != byRecency.rend(); ++it) {
+            all.emplace_back(*it, sessions.find(*it)->second.session);
+        }
+        return all;
+    }
+
+    std::size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sessions.size();
+    }
+};
+
+#endif  // CHESS_SESSION_REGISTRY_H
@@ -0,0 +1,133 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "session_registry.hpp"
+
+#ifndef CHESS_SESSION_SNAPSHOT_H
+#define CHESS_SESSION_SNAPSHOT_H
+
+/*
+Session snapshots:
+------------------
+Every game of a SessionRegistry written to one file, and read back into a
+registry, so games outlive a server restart.
+
+File layout (little-endian): 8-byte magic naming the game format, uint64
+session count, then per session uint32 id length, the id, uint32 game
+length and the game's bytes. Sessions are stored least recently used first,
+so restoring them keeps their order for eviction.
+
+How a game turns into bytes is up to the caller: `save(game, out)` appends
+a game to `out` and `restore(game, data, size)` reads one back, throwing if
+it cannot. Saving holds and locks one session at a time, and only while its
+game is copied out, so games keep being played, and idle sessions can still be
+evicted for new players, during a snapshot.
+*/
+
+namespace snapshot_detail {
+
+inline void appendU32(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Read one field, a uint32 length and that many bytes, into `bytes`. Returns
+// false if the file ends first, without allocating more than is left of it.
+inline bool readField(std::ifstream& in, uint64_t& remaining, std::string& bytes) {
+    uint32_t size = 0;
+    if (remaining < sizeof(size) || !in.read(reinterpret_cast<char*>(&size), sizeof(size))) return false;
+    remaining -= sizeof(size);
+    if (size > remaining) return false;
+    bytes.assign(size, '\0');
+    if (size > 0 && !in.read(&bytes[0], size)) return false;
+    remaining -= size;
+    return true;
+}
+
+}  // namespace snapshot_detail
+
+// Write every session of `registry` to `path`, replacing it only once the
+// new file is complete. Returns the number of sessions written.
+template <typename GameType, typename Save>
+std::size_t saveSessions(SessionRegistry<GameType>& registry, const std::string& path,
+                         const char (&magic)[8], Save save) {
+    std::string out;
+    std::string game;
+    std::size_t count = 0;
+    for (const auto& entry : registry.list()) {
+        game.clear();
+        {
+            std::shared_ptr<Session<GameType>> session = entry.second.lock();
+            if (!session) continue;  // ended or evicted since the listing
+            std::lock_guard<std::mutex> lock(session->mutex);
+            save(session->game, game);
+        }
+        snapshot_detail::appendU32(out, static_cast<uint32_t>(entry.first.size()));
+        out += entry.first;
+        snapshot_detail::appendU32(out, static_cast<uint32_t>(game.size()));
+        out += game;
+        count++;
+    }
+
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) throw std::runtime_error("Session snapshot: cannot open " + temporary);
+        const uint64_t sessions = count;
+        file.write(magic, sizeof(magic));
+        file.write(reinterpret_cast<const char*>(&sessions), sizeof(sessions));
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        if (!file) throw std::runtime_error("Session snapshot: write failed for " + temporary);
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Session snapshot: cannot replace " + path);
+    }
+    return count;
+}
+
+// Restore the sessions saved in `path` into `registry`, replacing games with
+// the same id. Games that fail to restore are skipped, and a truncated file
+// restores the sessions before the cut. Returns the number restored.
+template <typename GameType, typename Restore>
+std::size_t loadSessions(SessionRegistry<GameType>& registry, const std::string& path,
+                         const char (&magic)[8], Restore restore) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Session snapshot: cannot open " + path);
+    char header[8];
+    uint64_t count = 0;
+    in.read(header, sizeof(header));
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!in || std::memcmp(header, magic, sizeof(header)) != 0) {
+        throw std::runtime_error("Session snapshot: bad magic in " + path);
+    }
+
+    // Field lengths are checked against what is left of the file before anything is allocated
+    const std::streamoff start = in.tellg();
+    in.seekg(0, std::ios::end);
+    uint64_t remaining = static_cast<uint64_t>(in.tellg() - start);
+    in.seekg(start);
+
+    std::size_t restored = 0;
+    std::string id;
+    std::string game;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!snapshot_detail::readField(in, remaining, id) || !snapshot_detail::readField(in, remaining, game)) break;
+        std::shared_ptr<Session<GameType>> session = registry.acquire(id);
+        std::lock_guard<std::mutex> lock(session->mutex);
+        try {
+            restore(session->game, game.data(), game.size());
+            restored++;
+        } catch (const std::exception&) {
+            // Keep going: one bad game should not cost every other player theirs
+        }
+    }
+    return restored;
+}
+
+#endif  // CHESS_SESSION_SNAPSHOT_H
@@ -20,8 +20,12 @@ private:
     }
 
 public:
-    // Interpret 'a', 1
-    Square(char row, int rank) : valid{true} {encode(row,rank);}
+    // Interpret 'a', 1. Squares off the board are invalid, like Square()
+    Square(char row, int rank)
+        : valid{'a' <= row && row <= 'h' && 1 <= rank && rank <= 8} {
+        if (valid) encode(row, rank);
+        else encode('a', 1);
+    }
 
     // Interpret "a1"
     Square(std::string square) : Square(square.at(0), atoi(&square.at(1))) {}
@@ -33,6 +37,12 @@ public:
     char row() const {return decode().first;}
     int rank() const {return decode().second;}
 
+    // Position in a 64-entry board array (a1=0, a2=1, ..., h8=63),
+    // and whether this is a real square at all. Invalid squares index 0,
+    // so check isValid() before trusting index()
+    int index() const {return encoder - '0';}
+    bool isValid() const {return valid;}
+
     // Enable printing a square to the terminal
     friend std::ostream& operator<<(std::ostream& os, const Square& b);
 
@@ -1,4 +1,3 @@
-#include <map>
 #include <optional>
 #include <sstream>
 #include <stdexcept>
@@ -42,10 +41,6 @@ class State {
     int halfmoves;
     int fullmoves;
 
-    // Additional info for faster checking which squares have which pieces
-    // TODO make unordered map?
-    std::map<Square, Figure> figures;
-
     // Analyze if a castling move is meaningful, i.e. king and rook where
     // they should be, and no pieces in-between. No checks or castling
     // availability are analyzed.
@@ -56,24 +51,24 @@ class State {
             if (b.WKing != Square("e1")) return false;
             if (m.side == CASTLING::KINGSIDE) {
                 // Rook on h1
-                auto rook = figures.find({"h1"});
-                if (rook == figures.end()) return false;
-                if (rook->second.shape.value_or(Shape::QUEEN)
+                const std::optional<Figure>& rook = b.figureAt({"h1"});
+                if (!rook.has_value()) return false;
+                if (rook.value().shape.value_or(Shape::QUEEN)
                     != Shape::ROOK) return false;
                 // f1, g1 empty
-                return (figures.find({"f1"}) == figures.end()) &&
-                    (figures.find({"g1"}) == figures.end());
+                return !b.colourPresent({"f1"}).has_value() &&
+                    !b.colourPresent({"g1"}).has_value();
             } else {
                 // Queenside
                 // Rook on a1
-                auto rook = figures.find({"a1"});
-                if (rook == figures.end()) return false;
-                if (rook->second.shape.value_or(Shape::QUEEN)
+                const std::optional<Figure>& rook = b.figureAt({"a1"});
+                if (!rook.has_value()) return false;
+                if (rook.value().shape.value_or(Shape::QUEEN)
                     != Shape::ROOK) return false;
                 // b1, c1, d1 empty
-                return (figures.find({"b1"}) == figures.end()) &&
-                    (figures.find({"c1"}) == figures.end()) &&
-                    (figures.find({"d1"}) == figures.end());
+                return !b.colourPresent({"b1"}).has_value() &&
+                    !b.colourPresent({"c1"}).has_value() &&
+                    !b.colourPresent({"d1"}).has_value();
             }
         }
         // Black moves
@@ -81,24 +76,24 @@ class State {
         if (b.BKing != Square("e8")) return false;
         if (m.side == CASTLING::KINGSIDE) {
             // Rook on h8
-            auto rook = figures.find({"h8"});
-            if (rook == figures.end()) return false;
-            if (rook->second.shape.value_or(Shape::QUEEN)
+            const std::optional<Figure>& rook = b.figureAt({"h8"});
+            if (!rook.has_value()) return false;
+            if (rook.value().shape.value_or(Shape::QUEEN)
                 != Shape::ROOK) return false;
             // f8, g8 empty
-            return (figures.find({"f8"}) == figures.end()) &&
-                (figures.find({"g8"}) == figures.end());
+            return !b.colourPresent({"f8"}).has_value() &&
+                !b.colourPresent({"g8"}).has_value();
         } else {
             // Queenside
             // Rook on a8
-            auto rook = figures.find({"a8"});
-            if (rook == figures.end()) return false;
-            if (rook->second.shape.value_or(Shape::QUEEN)
+            const std::optional<Figure>& rook = b.figureAt({"a8"});
+            if (!rook.has_value()) return false;
+            if (rook.value().shape.value_or(Shape::QUEEN)
                 != Shape::ROOK) return false;
             // b8, c8, d8 empty
-            return (figures.find({"b8"}) == figures.end()) &&
-                (figures.find({"c8"}) == figures.end()) &&
-                (figures.find({"d8"}) == figures.end());
+            return !b.colourPresent({"b8"}).has_value() &&
+                !b.colourPresent({"c8"}).has_value() &&
+                !b.colourPresent({"d8"}).has_value();
         }
     }
 
@@ -117,11 +112,11 @@ class State {
             if (!m.end.value().diagonallyInFront(m.start.value())) return false;
         }
         // start square must contain correct-colour pawn
-        auto pawn = figures.find(m.start.value());
-        if (pawn == figures.end()) return false;
-        if (pawn->second.shape.has_value() 
-            || pawn->second.king) return false;
-        return pawn->second.colour == m.player;
+        const std::optional<Figure>& pawn = b.figureAt(m.start.value());
+        if (!pawn.has_value()) return false;
+        if (pawn.value().shape.has_value() 
+            || pawn.value().king) return false;
+        return pawn.value().colour == m.player;
     }
 
     // Check if a capture move makes sense.
@@ -132,15 +127,15 @@ class State {
         if (m.type != MOVE::CAPTURE) return false;
 
         // Find own piece and enemy piece
-        auto mine = figures.find(m.start.value());
-        if (mine == figures.end()) return false;
-        if (mine->second.colour != m.player) return false;
-        auto enemy = figures.find(m.end.value());
-        if (enemy == figures.end()) return false;
-        if (enemy->second.colour == m.player) return false;
+        const std::optional<Figure>& mine = b.figureAt(m.start.value());
+        if (!mine.has_value()) return false;
+        if (mine.value().colour != m.player) return false;
+        const std::optional<Figure>& enemy = b.figureAt(m.end.value());
+        if (!enemy.has_value()) return false;
+        if (enemy.value().colour == m.player) return false;
 
         // Valid motion
-        return b.validMotion(mine->second, m.start.value(), m.end.value());
+        return b.validMotion(mine.value(), m.start.value(), m.end.value());
     }
 
     // Check if a normal move makes sense.
@@ -152,18 +147,18 @@ class State {
         if (m.type != MOVE::NORMAL) return false;
 
         // Find own piece and enemy piece
-        auto mine = figures.find(m.start.value());
-        if (mine == figures.end()) {
+        const std::optional<Figure>& mine = b.figureAt(m.start.value());
+        if (!mine.has_value()) {
             std::cout << "No piece found at "
                       << m.start.value() << std::endl;
             return false;
         }
-        if (mine->second.colour != m.player) {
+        if (mine.value().colour != m.player) {
             std::cout << "Piece found at "<< m.start.value()
                       << " has wrong colour" << std::endl;
             return false;
         }
-        if (figures.find(m.end.value()) != figures.end()) {
+        if (b.colourPresent(m.end.value()).has_value()) {
             std::cout << "Square " << m.end.value()
                       << " not empty" << std::endl;
             return false;
@@ -172,37 +167,13 @@ class State {
         std::cout << "Normal move passes initial tests, checking board now for validMotion" << std::endl;  // TODO delete
 
         // Valid motion
-        return b.validMotion(mine->second, m.start.value(), m.end.value());
+        return b.validMotion(mine.value(), m.start.value(), m.end.value());
     }
 
 public:
     State() : whiteToMove{true}, WKCastle{true}, WQCastle{true},
               BKCastle{true}, BQCastle{true}, enPassantSquare{},
-              halfmoves{0}, fullmoves{1}, figures{} {
-        // Insert King figures
-        figures.insert({{"e1"}, {Owner::WHITE, true}});
-        figures.insert({{"e8"}, {Owner::BLACK, true}});
-        // Insert pawns figures 
-        for (char c : {'a','b','c','d','e','f','g','h'}) {
-            figures.insert({{c, 2}, {Owner::WHITE, false}});
-            figures.insert({{c, 7}, {Owner::BLACK, false}});
-        }
-        // Insert piece figures
-        figures.insert({{"d1"}, {Shape::QUEEN, Owner::WHITE}});
-        figures.insert({{"d8"}, {Shape::QUEEN, Owner::BLACK}});
-        figures.insert({{"c1"}, {Shape::BISHOP, Owner::WHITE}});
-        figures.insert({{"c8"}, {Shape::BISHOP, Owner::BLACK}});
-        figures.insert({{"b1"}, {Shape::KNIGHT, Owner::WHITE}});
-        figures.insert({{"b8"}, {Shape::KNIGHT, Owner::BLACK}});
-        figures.insert({{"a1"}, {Shape::ROOK, Owner::WHITE}});
-        figures.insert({{"a8"}, {Shape::ROOK, Owner::BLACK}});
-        figures.insert({{"f1"}, {Shape::BISHOP, Owner::WHITE}});
-        figures.insert({{"f8"}, {Shape::BISHOP, Owner::BLACK}});
-        figures.insert({{"g1"}, {Shape::KNIGHT, Owner::WHITE}});
-        figures.insert({{"g8"}, {Shape::KNIGHT, Owner::BLACK}});
-        figures.insert({{"h1"}, {Shape::ROOK, Owner::WHITE}});
-        figures.insert({{"h8"}, {Shape::ROOK, Owner::BLACK}});
-    }
+              halfmoves{0}, fullmoves{1} {}
 
     /* Check if a contextless Move makes sense but not necessarily its legality
        A piece must exist there and be able to move to that spot with the given
@@ -270,14 +241,14 @@ public:
         // Legality capture: enemy piece there
         // TODO: No moving into check
         if (m.type == MOVE::CAPTURE) {
-            return (figures.find(m.end.value()) != figures.end())
-                && !(figures.find(m.end.value())->second.colour == m.player);
+            return b.colourPresent(m.end.value()).has_value()
+                && !(b.colourPresent(m.end.value()).value() == m.player);
         }
 
         // Legality normal move: end square empty
         // TODO: No moving into check
         if (m.type == MOVE::NORMAL) {
-            return figures.find(m.end.value()) == figures.end();
+            return !b.colourPresent(m.end.value()).has_value();
         }
 
         return false;
@@ -295,18 +266,15 @@ public:
         // Castle
         if (m.type == MOVE::CASTLE) {
 
-            // Change king in figures map and board
+            // Move king
             Square kingStart{(m.player == PLAYERTOMOVE::WHITE ? "e1" : "e8")};
             Square kingEnd{((m.player == PLAYERTOMOVE::WHITE) ? 
                 ((m.side.value() == CASTLING::KINGSIDE) ? "g1" : "c1") :
                 ((m.side.value() == CASTLING::KINGSIDE) ? "g8" : "c8")    
             )};
-            auto it = figures.find(kingStart);
-            figures.erase(it->first);
-            figures.insert({kingEnd, Figure{it->second.colour, true}});
             b.teletransport(kingStart, kingEnd);
 
-            // Change rook in figures map
+            // Move rook
             Square rookStart{((m.player == PLAYERTOMOVE::WHITE) ? 
                 ((m.side.value() == CASTLING::KINGSIDE) ? "h1" : "a1") :
                 ((m.side.value() == CASTLING::KINGSIDE) ? "h8" : "a8")    
@@ -315,9 +283,6 @@ public:
                 ((m.side.value() == CASTLING::KINGSIDE) ? "f1" : "d1") :
                 ((m.side.value() == CASTLING::KINGSIDE) ? "f8" : "d8")    
             )};
-            auto ii = figures.find(rookStart);
-            figures.erase(ii->first);
-            figures.insert({rookEnd, Figure{Shape::ROOK, ii->second.colour}});
             b.teletransport(rookStart, rookEnd);
 
             // Forbid future castling for this player
@@ -338,14 +303,6 @@ public:
                 ? m.end.value().squareBehind() 
                 : m.end.value().squareInFront();
 
-            // Change figures map
-            auto it = figures.find(m.start.value());
-            auto itt = figures.find(enemy);
-            figures.erase(itt->first);
-            Figure fig = it->second;
-            figures.erase(it->first);
-            figures.insert({m.end.value(), fig});
-
             // Change board
             b.kill(enemy);
             b.teletransport(m.start.value(), m.end.value());
@@ -354,15 +311,8 @@ public:
         // Capture
         if (m.type == MOVE::CAPTURE) {
 
-            // Change figures map
-            auto it = figures.find(m.start.value());
-            auto itt = figures.find(m.end.value());
-            figures.erase(itt->first);
-            Figure fig = it->second;
-            figures.erase(it->first);
-            figures.insert({m.end.value(), fig});
-
             // Change board
+            Figure fig = b.figureAt(m.start.value()).value();
             b.kill(m.end.value());
             b.teletransport(m.start.value(), m.end.value());
 
@@ -382,13 +332,8 @@ public:
         // Normal move
         if (m.type == MOVE::NORMAL) {
 
-            // Change figures map
-            auto it = figures.find(m.start.value());
-            Figure fig = it->second;
-            figures.erase(it->first);
-            figures.insert({m.end.value(), fig});
-
             // Change board
+            Figure fig = b.figureAt(m.start.value()).value();
             b.teletransport(m.start.value(), m.end.value());
 
             // Check if move enables en passant
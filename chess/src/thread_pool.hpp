@@ -0,0 +1,72 @@
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef CHESS_THREAD_POOL_H
+#define CHESS_THREAD_POOL_H
+
+/*
+ThreadPool Class:
+-----------------
+A fixed set of threads taking tasks off one queue, first in first out. The
+threads live as long as the pool, so work that arrives in many small pieces
+does not pay for starting threads.
+
+Destroying the pool waits for the running tasks and drops the queued ones.
+*/
+class ThreadPool {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::thread> threads;
+    bool closing = false;
+
+    void work() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return closing || !tasks.empty(); });
+                if (closing) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    explicit ThreadPool(std::size_t size) {
+        if (size == 0) size = 1;
+        for (std::size_t i = 0; i < size; ++i) threads.emplace_back([this] { work(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closing = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) thread.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queue `task` to run on one of the threads. Tasks must not throw.
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+    std::size_t size() const { return threads.size(); }
+};
+
+#endif  // CHESS_THREAD_POOL_H
@@ -0,0 +1,41 @@
+// Moves naming squares off the board are refused, and leave the game as it was.
+// Run with `npm test` once the addon is built.
+const assert = require('assert');
+const chessModule = require('../build/Release/chess.node');
+
+// Byte 67 of a board record, see Game::writeRecord in src/game.hpp
+const OUTCOME = {STARTED: 0, PLAYED: 1, ILLEGAL: 2, MEANINGLESS: 3};
+const MEANINGLESS = 'That move is meaningless. Try again.\n';
+
+// Raw notation names its squares outright, so off-board or malformed ones make it meaningless
+const RAW = [
+  'NORMAL,WHITE,a1,^0',
+  'NORMAL,WHITE,e2,z9',
+  'NORMAL,WHITE,e2,e9',
+  'NORMAL,WHITE,e2,e0',
+  'NORMAL,WHITE,i2,i4',
+  'CAPTURE,WHITE,d1,i5',
+  'ENPASSANT,WHITE,e5,`6',
+  'NORMAL,WHITE,e2',
+  'NORMAL,WHITE,,e4',
+  'NORMAL,WHITE,e,e4',
+  'NORMAL,WHITE,e2,4',
+  'CAPTURE,WHITE,e2,',
+  'NORMAL,WHITE,e2,e44',
+];
+// Algebraic notation is refused one way or the other
+const ALGEBRAIC = ['Kz9', 'Kxz9', 'Qi5', 'e9', 'exz9'];
+
+const session = 'offBoard';
+const start = chessModule.playMove(session, '__INITIATE_GAME__');
+for (const command of RAW) {
+  assert.strictEqual(chessModule.playMove(session, command), MEANINGLESS, command);
+  assert.strictEqual(chessModule.playMoveBinary(session, command)[67], OUTCOME.MEANINGLESS, command);
+}
+for (const command of ALGEBRAIC) {
+  assert.notStrictEqual(chessModule.playMoveBinary(session, command)[67], OUTCOME.PLAYED, command);
+}
+assert.strictEqual(chessModule.playMove(session, '__INITIATE_GAME__'), start, 'the board changed');
+assert.strictEqual(chessModule.playMoveBinary(session, 'e4')[67], OUTCOME.PLAYED);
+chessModule.endSession(session);
+console.log(`off_board: ${RAW.length + ALGEBRAIC.length} off-board moves refused`);
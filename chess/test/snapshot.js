@@ -0,0 +1,92 @@
+// Games saved with saveSessions() come back from loadSessions(), for both addons,
+// and a damaged snapshot restores what it can. Run with `npm test` once the addons are built.
+const assert = require('assert');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const chessModule = require('../build/Release/chess.node');
+const engine = require('../build/Release/chess2.node');
+
+const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'chess-snapshot-'));
+
+// A move that means nothing answers with the board as it stands, see Game::record in src/game.hpp
+const legacyBoard = id => chessModule.playMoveBinary(id, '__SHOW__').subarray(0, 67);
+
+// Snapshots written by `save`, then cut short or given an impossible length: loading
+// them restores the sessions before the damage instead of throwing
+function checkDamaged(file, addon, ids) {
+  const bytes = fs.readFileSync(file);
+  const damaged = path.join(dir, 'damaged.bin');
+
+  // The first session's id length is at byte 16, after the magic and the session count
+  const firstIdLength = bytes.readUInt32LE(16);
+  const secondSession = 16 + 4 + firstIdLength + 4 + bytes.readUInt32LE(16 + 4 + firstIdLength);
+  fs.writeFileSync(damaged, bytes.subarray(0, secondSession + 6));
+  assert.strictEqual(addon.loadSessions(damaged), 1, 'a truncated snapshot restores the sessions before the cut');
+
+  const huge = Buffer.from(bytes);
+  huge.writeUInt32LE(0xFFFFFFFF, 16);
+  fs.writeFileSync(damaged, huge);
+  assert.strictEqual(addon.loadSessions(damaged), 0, 'a length past the end of the file stops the restore');
+
+  fs.writeFileSync(damaged, bytes.subarray(0, 12));
+  assert.throws(() => addon.loadSessions(damaged), /bad magic/);
+  for (const id of ids) addon.endSession(id);
+}
+
+async function legacy() {
+  // Castling is saved without squares, so play one
+  const games = {
+    castled: ['e4', 'e5', 'Nf3', 'Nc6', 'Bc4', 'Bc5', 'O-O'],
+    fresh: [],
+  };
+  const boards = {};
+  for (const [id, moves] of Object.entries(games)) {
+    chessModule.playMove(id, '__INITIATE_GAME__');
+    for (const move of moves) assert.strictEqual(chessModule.playMoveBinary(id, move)[67], 1, move);
+    boards[id] = legacyBoard(id);
+  }
+  const file = path.join(dir, 'sessions-chess.bin');
+  assert.strictEqual(await chessModule.saveSessions(file), Object.keys(games).length);
+  for (const id of Object.keys(games)) chessModule.endSession(id);
+
+  assert.strictEqual(chessModule.loadSessions(file), Object.keys(games).length);
+  for (const id of Object.keys(games)) assert.deepStrictEqual(legacyBoard(id), boards[id], id);
+  // The restored game carries on from where it was: black to move after O-O
+  assert.strictEqual(chessModule.playMoveBinary('castled', 'd6')[67], 1);
+  checkDamaged(file, chessModule, Object.keys(games));
+}
+
+async function chess2() {
+  const games = {
+    opening: [undefined, ['e4', 'c5', 'Nf3', 'd6', 'd4', 'cxd4', 'Nxd4']],
+    fromFen: ['4k3/8/8/8/8/8/4P3/4K3 w - - 0 1', ['e4', 'Kd7', 'Kd2']],
+  };
+  const states = {};
+  for (const [id, [fen, moves]] of Object.entries(games)) {
+    engine.newGame(id, fen);
+    for (const move of moves) engine.move(id, move);
+    states[id] = engine.state(id);
+  }
+  const file = path.join(dir, 'sessions-chess2.bin');
+  assert.strictEqual(await engine.saveSessions(file), Object.keys(games).length);
+  for (const id of Object.keys(games)) engine.endSession(id);
+
+  assert.strictEqual(engine.loadSessions(file), Object.keys(games).length);
+  for (const id of Object.keys(games)) assert.deepStrictEqual(engine.state(id), states[id], id);
+  assert.ok(engine.legalMoves('fromFen').includes('Kc7'));
+  checkDamaged(file, engine, Object.keys(games));
+}
+
+(async () => {
+  try {
+    await legacy();
+    await chess2();
+  } finally {
+    fs.rmSync(dir, {recursive: true, force: true});
+  }
+  console.log('snapshot: both addons round-trip their games');
+})().catch(err => {
+  console.error(err);
+  process.exit(1);
+});
@@ -4,7 +4,9 @@
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 #include "lawyer.h"
 #include "square_utils.h"
 #include "move.h"
@@ -52,181 +54,267 @@ inline std::string disambiguate_piece(const Board& board, const Move& move, cons
     return output;
 }
 
-inline Board board_after_move(const Board& board, const Move& move) {
-    Board result(board);
-    const int fromX = move.from_x();
-    const int fromY = move.from_y();
-    const int toX = move.to_x();
-    const int toY = move.to_y();
-    int from_idx = result.find_piece_at(fromX, fromY);
-    if (from_idx == -1) throw std::runtime_error("Mover not found");
-    int to_idx = result.find_piece_at(toX, toY);
-    const Piece mover = result.get_piece(from_idx);
-    CastlingRights cr = result.get_castling_rights();
+// Disambiguation using an already generated list of legal moves from `board`.
+inline std::string disambiguate_piece(const Board& board, const Move& move, const Piece& mover,
+                                      const std::vector<Move>& legal_moves) {
+    if (mover.kind == PieceKind::Pawn) return "";
 
-    if (move.is_attempted_castling()) {
-        const bool kingside = move.is_attempted_kingside_castling();
-        const int rook_from_x = kingside ? 7 : 0;
-        const int rook_to_x = kingside ? (fromX + 1) : (fromX - 1);
-        const int rook_idx = result.find_piece_at(rook_from_x, fromY);
-        if (rook_idx == -1) throw std::runtime_error("Castling rook missing");
-        result.teletransport_piece(rook_idx, rook_to_x, fromY);
-        if (mover.white) {
-            cr.white_kingside = false;
-            cr.white_queenside = false;
-        } else {
-            cr.black_kingside = false;
-            cr.black_queenside = false;
-        }
-    } else if (move.is_attempted_en_passant()) {
-        const int capture_idx = result.find_piece_at(toX, fromY);
-        if (capture_idx == -1) throw std::runtime_error("En-passant capture missing");
-        const bool adjust_from = capture_idx < from_idx;
-        result.delete_piece(capture_idx);
-        if (adjust_from) --from_idx;
-    } else if (move.is_attempted_capture() && to_idx != -1) {
-        const Piece& captured = result.get_piece(to_idx);
-        cr.revoke_for_rook(captured);
-        const bool adjust_from = to_idx < from_idx;
-        result.delete_piece(to_idx);
-        if (adjust_from) --from_idx;
+    bool conflict_found = false;
+    bool file_unique = true;
+    bool rank_unique = true;
+    for (const Move& other : legal_moves) {
+        if (other.to_x() != move.to_x() || other.to_y() != move.to_y()) continue;
+        if (other.from_x() == mover.x && other.from_y() == mover.y) continue;
+        const Piece& candidate = board.get_piece(board.find_piece_at(other.from_x(), other.from_y()));
+        if (candidate.kind != mover.kind) continue;
+        conflict_found = true;
+        if (candidate.x == mover.x) file_unique = false;
+        if (candidate.y == mover.y) rank_unique = false;
     }
 
-    if (move.is_attempted_promotion()) {
-        if (!move.has_promotion()) throw std::runtime_error("Promotion missing");
-        result.change_pawn_kind(from_idx, move.get_promotion());
+    if (!conflict_found) return "";
+
+    std::string output;
+    if (file_unique) {
+        output.push_back(file_char(mover.x));
+    } else if (rank_unique) {
+        output.push_back(rank_char(mover.y));
+    } else {
+        output.push_back(file_char(mover.x));
+        output.push_back(rank_char(mover.y));
     }
+    return output;
+}
 
-    result.teletransport_piece(from_idx, toX, toY);
+// SAN without any check/mate mark or result. `disambiguation` is computed by the caller.
+inline std::string san_body(const Move& move, const Piece& mover, const std::string& disambiguation) {
+    if (move.is_attempted_castling()) {
+        return move.is_attempted_kingside_castling() ? "O-O" : "O-O-O";
+    }
+    std::string notation;
+    const bool is_pawn = mover.kind == PieceKind::Pawn;
+    if (!is_pawn) {
+        notation.push_back(kind_to_char(mover.kind));
+        notation += disambiguation;
+    }
 
-    if (move.is_attempted_initial_two_square_pawn_move()) {
-        const int direction = mover.white ? 1 : -1;
-        const EnPassantVulnerable vulnerable = mover.white ?
-            EnPassantVulnerable::White : EnPassantVulnerable::Black;
-        result.set_en_passant(EnPassant(fromX, fromY + direction, vulnerable));
-    } else {
-        result.clear_en_passant();
+    if (is_pawn && move.is_attempted_capture()) {
+        notation.push_back(file_char(mover.x));
     }
 
-    if (mover.kind == PieceKind::King) {
-        if (mover.white) {
-            cr.white_kingside = false;
-            cr.white_queenside = false;
-        } else {
-            cr.black_kingside = false;
-            cr.black_queenside = false;
-        }
-    } else if (mover.kind == PieceKind::Rook) {
-        cr.revoke_for_rook(mover);
+    if (move.is_attempted_capture()) {
+        notation.push_back('x');
     }
 
-    result.set_castling(cr);
+    notation += square_to_string(move.to_x(), move.to_y());
 
-    result.toggle_white_to_move();
-    return result;
+    if (move.is_attempted_promotion()) {
+        if (!move.has_promotion()) throw std::runtime_error("Promotion choice missing");
+        notation.push_back('=');
+        notation.push_back(kind_to_char(move.get_promotion()));
+    }
+    return notation;
 }
 
-} // namespace algebraic_notation_detail
-
-inline std::string to_algebraic_notation(const Move& move, const Board& board) {
+inline const Piece& mover_of(const Board& board, const Move& move) {
     const int mover_idx = board.find_piece_at(move.from_x(), move.from_y());
     if (mover_idx == -1) throw std::runtime_error("Mover missing for notation");
-    const Piece mover = board.get_piece(mover_idx);
-    std::string notation;
-
-    if (move.is_attempted_castling()) {
-        notation = move.is_attempted_kingside_castling() ? "O-O" : "O-O-O";
-    } else {
-        const bool is_pawn = mover.kind == PieceKind::Pawn;
-        if (!is_pawn) {
-            notation.push_back(kind_to_char(mover.kind));
-            notation += algebraic_notation_detail::disambiguate_piece(board, move, mover);
-        }
-
-        if (is_pawn && move.is_attempted_capture()) {
-            notation.push_back(algebraic_notation_detail::file_char(mover.x));
-        }
-
-        if (move.is_attempted_capture()) {
-            notation.push_back('x');
-        }
-
-        notation += algebraic_notation_detail::square_to_string(move.to_x(), move.to_y());
+    return board.get_piece(mover_idx);
+}
 
-        if (move.is_attempted_promotion()) {
-            if (!move.has_promotion()) throw std::runtime_error("Promotion choice missing");
-            notation.push_back('=');
-            notation.push_back(kind_to_char(move.get_promotion()));
-        }
-    }
+} // namespace algebraic_notation_detail
 
-    Board after = algebraic_notation_detail::board_after_move(board, move);
+/*
+* How much of the position after the move to_algebraic_notation() looks at:
+* - None:  no suffix at all. The resulting board is never built.
+* - Check: '+' or '#'. Mate detection only runs when the move gives check.
+* - Full:  '+' or '#', plus the result ("1-0", "0-1", "1/2-1/2") if the move ends the game.
+*          This needs a full game_status() on every move, to find stalemates.
+*/
+enum class SanSuffix { None, Check, Full };
+
+// The suffix of a (legal) move's SAN, including the leading space before a result.
+// Callers that wrote the body with SanSuffix::None can compute this later, if at all.
+inline std::string san_suffix(const Move& move, const Board& board, SanSuffix suffix = SanSuffix::Full) {
+    if (suffix == SanSuffix::None) return "";
+    Lawyer& lawyer = Lawyer::instance();
+    Board after(board);
+    after.detach_accumulator();  // only used for check detection
+    lawyer.perform_legal_move(after, move);
     const bool opponent_in_check = after.is_player_in_check(after.is_white_to_move());
-    const GameStatus status = Lawyer::instance().game_status(after, std::vector<Board>{});
+    if (suffix == SanSuffix::Check && !opponent_in_check) return "";
+
+    const GameStatus status = lawyer.game_status(after, std::vector<Board>{});
     if (status == GameStatus::ThreefoldRepetition) {
         throw std::runtime_error("Algebraic notation found a 3-fold repetition draw");
     }
 
+    std::string output;
     if (status == GameStatus::Checkmate) {
-        notation.push_back('#');
+        output.push_back('#');
     } else if (opponent_in_check) {
-        notation.push_back('+');
+        output.push_back('+');
     }
+    if (suffix == SanSuffix::Check) return output;
 
-    std::string outcome;
     if (status == GameStatus::Checkmate) {
         const bool winner_white = !after.is_white_to_move();
-        outcome = winner_white ? "1-0" : "0-1";
+        output += winner_white ? " 1-0" : " 0-1";
     } else if (status == GameStatus::Stalemate || status == GameStatus::FiftyMoveRule) {
-        outcome = "1/2-1/2";
+        output += " 1/2-1/2";
     }
+    return output;
+}
+
+// SAN of a legal move. `legal_moves` must be Lawyer::legal_moves(board) (or any list containing
+// every legal move), which callers printing many moves from one position generate only once.
+inline std::string to_algebraic_notation(const Move& move, const Board& board,
+                                         const std::vector<Move>& legal_moves,
+                                         SanSuffix suffix = SanSuffix::Full) {
+    const Piece& mover = algebraic_notation_detail::mover_of(board, move);
+    const std::string disambiguation = algebraic_notation_detail::disambiguate_piece(board, move, mover, legal_moves);
+    return algebraic_notation_detail::san_body(move, mover, disambiguation) + san_suffix(move, board, suffix);
+}
+
+inline std::string to_algebraic_notation(const Move& move, const Board& board, SanSuffix suffix = SanSuffix::Full) {
+    const Piece& mover = algebraic_notation_detail::mover_of(board, move);
+    const std::string disambiguation = algebraic_notation_detail::disambiguate_piece(board, move, mover);
+    return algebraic_notation_detail::san_body(move, mover, disambiguation) + san_suffix(move, board, suffix);
+}
+
+namespace algebraic_notation_detail {
 
-    if (!outcome.empty()) {
-        if (!notation.empty()) notation.push_back(' ');
-        notation += outcome;
+// The pieces of a SAN string such as "Nbxd7+", "exd6", "e8=Q#" or "O-O".
+struct SanTokens {
+    bool castling = false;
+    bool kingside = false;
+    PieceKind kind = PieceKind::Pawn;
+    int from_file = -1;  // disambiguation, -1 if absent
+    int from_rank = -1;
+    bool capture = false;
+    int to_x = -1, to_y = -1;
+    std::optional<PieceKind> promotion;
+};
+
+inline bool is_file(char c) { return c >= 'a' && c <= 'h'; }
+inline bool is_rank(char c) { return c >= '1' && c <= '8'; }
+
+// Split SAN into its parts. Check/mate marks, annotations ("!?") and anything after
+// the first space (e.g. a result such as "1-0") are ignored.
+inline std::optional<SanTokens> tokenize_san(const std::string& notation) {
+    size_t end = notation.find(' ');
+    if (end == std::string::npos) end = notation.size();
+    while (end > 0) {
+        const char c = notation[end - 1];
+        if (c != '+' && c != '#' && c != '!' && c != '?') break;
+        --end;
+    }
+    const std::string_view san(notation.data(), end);
+    if (san.empty()) return std::nullopt;
+
+    SanTokens tokens;
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        tokens.castling = true;
+        tokens.kingside = (san.size() == 3);
+        tokens.kind = PieceKind::King;
+        return tokens;
     }
 
-    return notation;
+    size_t begin = 0;
+    if (san[0] == 'K' || san[0] == 'Q' || san[0] == 'R' || san[0] == 'B' || san[0] == 'N') {
+        tokens.kind = char_to_kind(san[0]);
+        begin = 1;
+    }
+
+    // Promotion, with or without '='
+    size_t stop = san.size();
+    const char last = san[stop - 1];
+    if (last == 'Q' || last == 'R' || last == 'B' || last == 'N') {
+        if (tokens.kind != PieceKind::Pawn) return std::nullopt;
+        tokens.promotion = char_to_kind(last);
+        --stop;
+        if (stop > begin && san[stop - 1] == '=') --stop;
+    }
+
+    // Destination square
+    if (stop < begin + 2 || !is_file(san[stop - 2]) || !is_rank(san[stop - 1])) return std::nullopt;
+    tokens.to_x = san[stop - 2] - 'a';
+    tokens.to_y = san[stop - 1] - '1';
+    stop -= 2;
+
+    // Capture mark
+    if (stop > begin && (san[stop - 1] == 'x' || san[stop - 1] == ':')) {
+        tokens.capture = true;
+        --stop;
+    }
+
+    // Disambiguation: file, rank, or both
+    for (size_t i = begin; i < stop; ++i) {
+        const char c = san[i];
+        if (is_file(c) && tokens.from_file == -1 && tokens.from_rank == -1) {
+            tokens.from_file = c - 'a';
+        } else if (is_rank(c) && tokens.from_rank == -1) {
+            tokens.from_rank = c - '1';
+        } else {
+            return std::nullopt;
+        }
+    }
+    if (tokens.kind == PieceKind::Pawn) {
+        // Pawn captures name the origin file ("exd5"), pushes name nothing
+        if (tokens.from_rank != -1) return std::nullopt;
+        if (tokens.capture != (tokens.from_file != -1)) return std::nullopt;
+    }
+    return tokens;
 }
 
+} // namespace algebraic_notation_detail
+
+/*
+* Parse SAN directly: tokenize, then only look at the side-to-move's pieces of the
+* named kind that can reach the destination square. Returns nullopt if no legal move
+* matches or if the notation is ambiguous. Check and mate suffixes are not verified.
+*/
 inline std::optional<Move> from_algebraic_notation(const Board& board, const std::string& notation) {
+    const auto tokens_opt = algebraic_notation_detail::tokenize_san(notation);
+    if (!tokens_opt.has_value()) return std::nullopt;
+    const algebraic_notation_detail::SanTokens& tokens = tokens_opt.value();
     const bool white_to_move = board.is_white_to_move();
-    const int piece_count = board.get_piece_count();
-
-    auto matches_notation = [&](const Move& candidate) -> bool {
-        if (!Lawyer::instance().legal(board, candidate)) return false;
-        return to_algebraic_notation(candidate, board) == notation;
-    };
+    Lawyer& lawyer = Lawyer::instance();
+
+    if (tokens.castling) {
+        const int back_rank = white_to_move ? 0 : 7;
+        const int king_idx = board.find_piece_at(4, back_rank);
+        if (king_idx == -1) return std::nullopt;
+        const Piece& king = board.get_piece(king_idx);
+        if (king.kind != PieceKind::King || king.white != white_to_move) return std::nullopt;
+        Move move(4, back_rank, tokens.kingside ? 6 : 2, back_rank, board);
+        if (!move.is_valid() || !move.is_attempted_castling()) return std::nullopt;
+        if (!lawyer.legal(board, move)) return std::nullopt;
+        return move;
+    }
 
+    std::optional<Move> found;
+    const std::pair<int, int> target{tokens.to_x, tokens.to_y};
+    const int piece_count = board.get_piece_count();
     for (int idx = 0; idx < piece_count; ++idx) {
         const Piece& mover = board.get_piece(idx);
-        if (mover.white != white_to_move) continue;
+        if (mover.white != white_to_move || mover.kind != tokens.kind) continue;
+        if (tokens.from_file != -1 && mover.x != tokens.from_file) continue;
+        if (tokens.from_rank != -1 && mover.y != tokens.from_rank) continue;
+        if (tokens.kind == PieceKind::Pawn && !tokens.capture && mover.x != tokens.to_x) continue;
         const auto targets = board.get_targets(idx);
+        if (targets.find(target) == targets.end()) continue;
 
-        for (const auto& target : targets) {
-            Move move(mover.x, mover.y, target.first, target.second, board);
-            if (!move.is_valid()) continue;
-
-            if (!move.is_attempted_promotion()) {
-                if (matches_notation(move)) return move;
-                continue;
-            }
-
-            const PieceKind promotions[] = {
-                PieceKind::Queen,
-                PieceKind::Rook,
-                PieceKind::Bishop,
-                PieceKind::Knight
-            };
-            for (PieceKind promotion : promotions) {
-                Move candidate = move;
-                candidate.set_promotion(promotion);
-                if (matches_notation(candidate)) return candidate;
-            }
-        }
+        Move move(mover.x, mover.y, tokens.to_x, tokens.to_y, board);
+        if (!move.is_valid() || move.is_attempted_castling()) continue;
+        if (tokens.capture && !move.is_attempted_capture()) continue;
+        if (move.is_attempted_promotion() != tokens.promotion.has_value()) continue;
+        if (tokens.promotion.has_value()) move.set_promotion(tokens.promotion.value());
+        if (!lawyer.legal(board, move)) continue;
+        if (found.has_value()) return std::nullopt;  // ambiguous
+        found.emplace(move);
     }
-
-    return std::nullopt;
+    return found;
 }
 
 #endif // ALGEBRAIC_NOTATION_H
@@ -0,0 +1,59 @@
+#ifndef BACKGROUND_SEARCH_H
+#define BACKGROUND_SEARCH_H
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <optional>
+#include "board.h"
+#include "dfs.h"
+#include "move.h"
+
+/*
+* Class BackgroundSearch.
+* Runs DFS::explore on its own thread so a caller with a frame loop can keep
+* drawing. Poll done() once per frame, then take() the move. Destroying the
+* handle (or calling cancel()) stops the search and waits for the thread. A
+* deadline, if given, stops it too once passed (see SearchControl::deadline).
+*
+* The DFS must not be used by anyone else until the search is over.
+*/
+
+class BackgroundSearch {
+public:
+    BackgroundSearch(DFS& agent, const Board& board, int halfmove_clock,
+                     std::optional<std::chrono::steady_clock::time_point> deadline = std::nullopt)
+        : control_(std::make_shared<SearchControl>()) {
+        control_->deadline = deadline;
+        std::shared_ptr<SearchControl> control = control_;
+        result_ = std::async(std::launch::async, [&agent, board, halfmove_clock, control] {
+            return agent.explore(board, halfmove_clock, *control);
+        });
+    }
+
+    BackgroundSearch(const BackgroundSearch&) = delete;
+    BackgroundSearch& operator=(const BackgroundSearch&) = delete;
+
+    ~BackgroundSearch() {
+        cancel();
+        if (result_.valid()) result_.wait();
+    }
+
+    void cancel() { control_->stop.store(true, std::memory_order_relaxed); }
+
+    bool done() const {
+        return !result_.valid() || result_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    // The chosen move; rethrows whatever the search threw. Blocks if not done().
+    Move take() { return result_.get(); }
+
+    uint64_t nodes() const { return control_->nodes.load(std::memory_order_relaxed); }
+    int depth() const { return control_->depth.load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<SearchControl> control_;
+    std::future<Move> result_;
+};
+
+#endif // BACKGROUND_SEARCH_H
@@ -7,9 +7,12 @@
 #include <algorithm>
 #include <ostream>
 #include <string>
+#include <optional>
 #include "piece.h"
 #include "en_passant.h"
 #include "castling.h"
+#include "nnue.h"
+#include "zobrist.h"
 
 /*
 * Class Board.
@@ -30,6 +33,13 @@
 * Piece location is stored twice, in `pieces` and `occupancy`, because it's easier
 * to check things like if a rook move has no pieces in-between this way.
 *
+* Zobrist hashes of the whole position and of the pawns alone are kept up to date
+* by the mutators below (see zobrist.h).
+*
+* Optionally, the board also carries an NNUE accumulator (see nnue.h). It is copied
+* along with the board, so every child position in a search inherits its parent's
+* accumulator and the Lawyer only has to apply the move's delta.
+*
 * This does NOT store move history, so no undoes nor threefold repetition detection.
 * Knowledge of 3-fold repetition is unnecessary 
 * for a player agent that using graph algorithms
@@ -71,6 +81,34 @@ private:
     // player to move: true = white to move, false = black to move
     bool white_to_move = true;
 
+    // NNUE first-layer state, only present once attach_accumulator() is called
+    std::optional<nnue::Accumulator> accumulator;
+
+    // Zobrist hashes: everything, and pawns only (for the pawn structure cache)
+    uint64_t hash = 0;
+    uint64_t pawn_key = 0;
+
+    static uint64_t castling_key(const CastlingRights& cr) {
+        return zobrist::KEYS.castling[zobrist::castling_index(
+            cr.white_kingside, cr.white_queenside, cr.black_kingside, cr.black_queenside)];
+    }
+    uint64_t en_passant_key(void) const {
+        return en_passant.is_active() ? zobrist::KEYS.en_passant_file[en_passant.get_x()] : 0;
+    }
+    // XOR a piece in or out of both hashes
+    void toggle_piece_keys(const Piece& p) {
+        const uint64_t k = zobrist::piece_key(p.kind, p.white, p.x, p.y);
+        hash ^= k;
+        if (p.kind == PieceKind::Pawn) pawn_key ^= k;
+    }
+    void recompute_keys(void) {
+        hash = 0;
+        pawn_key = 0;
+        for (const Piece& p : pieces) toggle_piece_keys(p);
+        hash ^= castling_key(castling) ^ en_passant_key();
+        if (!white_to_move) hash ^= zobrist::KEYS.black_to_move;
+    }
+
 public:
     // Construtor produces an empty board with no casting nor en passant rights.
     // For a starting position, call reset().
@@ -110,6 +148,46 @@ public:
         for (size_t i = 0; i < pieces.size(); i++) {
             occupancy[pieces[i].x][pieces[i].y] = i;
         }
+        recompute_keys();
+        if (accumulator.has_value()) {
+            attach_accumulator(*accumulator->network);
+        }
+    }
+
+    // Remove every piece and all auxiliary state (empty board, white to move),
+    // keeping the allocated capacity so a board can be refilled cheaply, e.g. by FEN parsing.
+    void clear(void) {
+        pieces.clear();
+        castling = CastlingRights{};
+        en_passant = EnPassant{};
+        white_to_move = true;
+        for (int i=0; i<8; i++) {
+            for (int j=0; j<8; j++) {
+                occupancy[i][j] = -1;
+            }
+        }
+        recompute_keys();
+        if (accumulator.has_value()) {
+            attach_accumulator(*accumulator->network);
+        }
+    }
+
+    // Add a piece. The target square must be empty.
+    void place_piece(const Piece& piece) {
+        if (!in_bounds(piece.x, piece.y)) {
+            throw std::runtime_error("place_piece: square out of bounds");
+        }
+        if (occupancy[piece.x][piece.y] != -1) {
+            throw std::runtime_error("place_piece: target square non-empty");
+        }
+        occupancy[piece.x][piece.y] = (int)pieces.size();
+        pieces.push_back(piece);
+        toggle_piece_keys(piece);
+        if (accumulator.has_value()) {
+            nnue::FeatureDelta delta;
+            delta.add(piece.kind, piece.white, piece.x, piece.y);
+            nnue::apply_delta(*accumulator, delta);
+        }
     }
 
     // Get a const reference of piece at index idx.
@@ -131,8 +209,10 @@ public:
         }
         occupancy[pieces[idx].x][pieces[idx].y]= -1;
         occupancy[x][y] = idx;
+        toggle_piece_keys(pieces[idx]);
         pieces[idx].x = x;
         pieces[idx].y = y;
+        toggle_piece_keys(pieces[idx]);
     }
 
     // Promote a pawn to another piece kind. This ONLY changes its piece kind.
@@ -143,7 +223,9 @@ public:
         if (pieces[idx].kind != PieceKind::Pawn) {
             throw std::runtime_error("promote_pawn: piece is not a pawn");
         }
+        toggle_piece_keys(pieces[idx]);
         pieces[idx].kind = newKind;
+        toggle_piece_keys(pieces[idx]);
     }
 
     // Get total piece count
@@ -167,6 +249,7 @@ public:
                 }
             }
         }
+        toggle_piece_keys(pieces[idx]);
         pieces.erase(pieces.begin() + idx);
     }
 
@@ -176,6 +259,11 @@ public:
 
     void toggle_white_to_move() {
         white_to_move = !white_to_move;
+        hash ^= zobrist::KEYS.black_to_move;
+    }
+
+    void set_white_to_move(bool white) {
+        if (white != white_to_move) toggle_white_to_move();
     }
 
     // find index of piece at square (x,y) or -1 if no piece
@@ -184,15 +272,40 @@ public:
     }
 
     // en-passant helpers
-    void set_en_passant(EnPassant ep) { en_passant = ep; }
-    void clear_en_passant(void) { en_passant = EnPassant{}; }
+    void set_en_passant(EnPassant ep) {
+        hash ^= en_passant_key();
+        en_passant = ep;
+        hash ^= en_passant_key();
+    }
+    void clear_en_passant(void) { set_en_passant(EnPassant{}); }
     bool has_en_passant(void) const { return en_passant.is_active(); }
     EnPassant get_en_passant() const { return en_passant; }
 
     // convenience: set or get (by copy) castling rights
-    void set_castling(CastlingRights cr) { castling = cr; }
+    void set_castling(CastlingRights cr) {
+        hash ^= castling_key(castling) ^ castling_key(cr);
+        castling = cr;
+    }
     CastlingRights get_castling_rights() const { return castling; }
 
+    // Zobrist hash of the full position (pieces, castling, en passant, side to move)
+    uint64_t get_hash(void) const { return hash; }
+    // Zobrist hash of the pawns alone
+    uint64_t get_pawn_key(void) const { return pawn_key; }
+
+    // NNUE accumulator helpers.
+    // attach_accumulator() computes it from scratch; afterwards Lawyer::perform_move keeps it updated.
+    void attach_accumulator(const nnue::Network& network) {
+        accumulator.emplace();
+        nnue::refresh(*accumulator, network, [&](auto&& add_piece) {
+            for (const Piece& p : pieces) add_piece(p.kind, p.white, p.x, p.y);
+        });
+    }
+    void detach_accumulator(void) { accumulator.reset(); }
+    bool has_accumulator(void) const { return accumulator.has_value(); }
+    const nnue::Accumulator& get_accumulator(void) const { return accumulator.value(); }
+    nnue::Accumulator& get_accumulator(void) { return accumulator.value(); }
+
     friend std::ostream& operator<<(std::ostream& os, const Board& board);
 
     // Is castling a valid move?
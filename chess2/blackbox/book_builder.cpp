@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "book_builder.h"
+
+/*
+* book_builder
+* Builds an opening book for jco (--book) from PGN archives.
+*
+*   book_builder -o book.bin [-j threads] [--max-ply N] [--min-games N] [--memory-mb N] games.pgn...
+*/
+
+static void usage(void) {
+    std::cerr << "usage: book_builder -o <book> [-j <threads>] [--max-ply <plies>] [--min-games <games>]\n"
+                 "                    [--memory-mb <megabytes>] <pgn>...\n";
+}
+
+int main(int argc, char** argv) {
+    book::BuildOptions options;
+    options.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::string output;
+    std::vector<std::string> inputs;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool has_value = i + 1 < argc;
+            if ((arg == "-o" || arg == "--output") && has_value) {
+                output = argv[++i];
+            } else if ((arg == "-j" || arg == "--threads") && has_value) {
+                options.threads = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--max-ply" && has_value) {
+                options.max_ply = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--min-games" && has_value) {
+                options.min_games = static_cast<uint32_t>(std::max(1, std::stoi(argv[++i])));
+            } else if (arg == "--memory-mb" && has_value) {
+                options.memory_bytes = static_cast<size_t>(std::max(1, std::stoi(argv[++i]))) << 20;
+            } else if (!arg.empty() && arg[0] == '-') {
+                usage();
+                return 1;
+            } else {
+                inputs.push_back(arg);
+            }
+        }
+    } catch (const std::exception&) {
+        usage();
+        return 1;
+    }
+    if (output.empty() || inputs.empty()) {
+        usage();
+        return 1;
+    }
+
+    try {
+        const book::BuildStats stats = book::build(inputs, output, options);
+        std::cout << "Games used:      " << stats.games << "\n"
+                  << "Games skipped:   " << stats.skipped_games << "\n"
+                  << "Positions:       " << stats.positions << "\n"
+                  << "Sorted runs:     " << stats.runs << "\n"
+                  << "Book entries:    " << stats.entries << "\n";
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,356 @@
+#ifndef BOOK_BUILDER_H
+#define BOOK_BUILDER_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "board.h"
+#include "opening_book.h"
+#include "pgn.h"
+
+/*
+* Builds an opening book (see opening_book.h) from PGN archives.
+*
+* 1. One thread splits the archives into batches of game text; a bounded queue
+*    keeps at most a few batches in memory.
+* 2. Worker threads parse and replay the batches (pgn::for_each_position) and
+*    count, per (position, move), the games and their results for the side to move.
+*    When a worker's counts reach its share of the memory budget they are sorted,
+*    collapsed and written to a temporary run file.
+* 3. The runs are k-way merged, still sorted by (position, move), and each
+*    position's moves are turned into book weights on the fly.
+*
+* Memory is bounded by the budget plus the queued batches, whatever the input size.
+*/
+
+namespace book {
+
+struct BuildOptions {
+    int threads = 1;
+    int max_ply = 30;              // only positions within the first max_ply plies
+    uint32_t min_games = 1;        // drop moves played in fewer games
+    size_t memory_bytes = size_t{256} << 20;
+    size_t batch_games = 512;      // games per unit of work
+    std::string temp_prefix;       // run files are temp_prefix + ".runN"; defaults to the output path
+};
+
+struct BuildStats {
+    uint64_t games = 0;            // games used
+    uint64_t skipped_games = 0;    // unfinished ("*"), malformed or illegal games
+    uint64_t positions = 0;        // (position, move) samples counted
+    uint64_t runs = 0;             // temporary run files written
+    uint64_t entries = 0;          // entries in the book
+};
+
+namespace builder_detail {
+
+// Aggregated results of one move from one position, for the side that played it.
+struct Count {
+    uint64_t key;
+    uint16_t move;
+    uint32_t games;
+    uint32_t wins;
+    uint32_t draws;
+};
+
+inline bool same_move(const Count& lhs, const Count& rhs) { return lhs.key == rhs.key && lhs.move == rhs.move; }
+inline bool count_less(const Count& lhs, const Count& rhs) {
+    return lhs.key != rhs.key ? lhs.key < rhs.key : lhs.move < rhs.move;
+}
+
+inline void add(Count& into, const Count& from) {
+    into.games += from.games;
+    into.wins += from.wins;
+    into.draws += from.draws;
+}
+
+// Sort `counts` and merge equal (position, move) pairs in place.
+inline void collapse(std::vector<Count>& counts) {
+    std::sort(counts.begin(), counts.end(), count_less);
+    size_t out = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (out > 0 && same_move(counts[out - 1], counts[i])) {
+            add(counts[out - 1], counts[i]);
+        } else {
+            counts[out++] = counts[i];
+        }
+    }
+    counts.resize(out);
+}
+
+// Sorted, collapsed counts on disk.
+class RunReader {
+public:
+    explicit RunReader(const std::string& path) : in_(path, std::ios::binary) {
+        if (!in_) throw std::runtime_error("book::build: cannot reopen run " + path);
+        advance();
+    }
+    bool done(void) const { return done_; }
+    const Count& current(void) const { return current_; }
+    void advance(void) {
+        in_.read(reinterpret_cast<char*>(&current_), sizeof(current_));
+        done_ = !in_;
+    }
+
+private:
+    std::ifstream in_;
+    Count current_{};
+    bool done_ = false;
+};
+
+// A batch of raw PGN text holding whole games.
+struct Batch {
+    std::string text;
+};
+
+class BatchQueue {
+public:
+    explicit BatchQueue(size_t capacity) : capacity_(capacity) {}
+
+    void push(Batch batch) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [&] { return batches_.size() < capacity_; });
+        batches_.push_back(std::move(batch));
+        not_empty_.notify_one();
+    }
+
+    // False once the queue is closed and drained.
+    bool pop(Batch& batch) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [&] { return !batches_.empty() || closed_; });
+        if (batches_.empty()) return false;
+        batch = std::move(batches_.front());
+        batches_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void close(void) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<Batch> batches_;
+    size_t capacity_;
+    bool closed_ = false;
+};
+
+// Cut the archives into batches at game boundaries: a tag line after movetext.
+inline void split_archives(const std::vector<std::string>& paths, size_t batch_games, BatchQueue& queue) {
+    Batch batch;
+    size_t games = 0;
+    std::string line;
+    for (const std::string& path : paths) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("book::build: cannot open " + path);
+        bool in_movetext = false;
+        while (std::getline(in, line)) {
+            const bool tag_line = !line.empty() && line[0] == '[';
+            if (tag_line && in_movetext) {
+                in_movetext = false;
+                if (++games >= batch_games) {
+                    queue.push(std::move(batch));
+                    batch = Batch{};
+                    games = 0;
+                }
+            } else if (!tag_line && !line.empty()) {
+                in_movetext = true;
+            }
+            batch.text += line;
+            batch.text.push_back('\n');
+        }
+        // Don't let a game without a result run into the next file's first game
+        batch.text.push_back('\n');
+    }
+    if (!batch.text.empty()) queue.push(std::move(batch));
+}
+
+class RunFiles {
+public:
+    explicit RunFiles(std::string prefix) : prefix_(std::move(prefix)) {}
+    ~RunFiles() {
+        for (const std::string& path : paths_) std::remove(path.c_str());
+    }
+
+    // Write `counts` (sorted and collapsed) as a new run.
+    void write(const std::vector<Count>& counts) {
+        std::string path;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            path = prefix_ + ".run" + std::to_string(paths_.size());
+            paths_.push_back(path);
+        }
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(counts.data()), static_cast<std::streamsize>(counts.size() * sizeof(Count)));
+        if (!out) throw std::runtime_error("book::build: cannot write run " + path);
+    }
+
+    const std::vector<std::string>& paths(void) const { return paths_; }
+
+private:
+    std::string prefix_;
+    std::mutex mutex_;
+    std::vector<std::string> paths_;
+};
+
+/*
+* Weights for one position's moves: points scored by the side to move (a win is 2,
+* a draw 1), scaled down together if the best one does not fit in 16 bits.
+* Moves that never scored get weight 0: kept in the book, never chosen.
+*/
+inline void write_position(const std::vector<Count>& moves, uint32_t min_games, Writer& writer, BuildStats& stats) {
+    uint64_t best = 0;
+    for (const Count& c : moves) {
+        if (c.games < min_games) continue;
+        best = std::max<uint64_t>(best, uint64_t{2} * c.wins + c.draws);
+    }
+    for (const Count& c : moves) {
+        if (c.games < min_games) continue;
+        uint64_t points = uint64_t{2} * c.wins + c.draws;
+        if (best > 0xFFFF) points = (points * 0xFFFF + best - 1) / best;  // round up, so scoring moves stay above 0
+        writer.append(Entry{c.key, c.move, static_cast<uint16_t>(points), c.games});
+        ++stats.entries;
+    }
+}
+
+} // namespace builder_detail
+
+inline BuildStats build(const std::vector<std::string>& pgn_paths, const std::string& output, BuildOptions options = BuildOptions()) {
+    using namespace builder_detail;
+    const int threads = std::max(1, options.threads);
+    const size_t run_capacity = std::max<size_t>(1024, options.memory_bytes / sizeof(Count) / static_cast<size_t>(threads));
+    RunFiles runs(options.temp_prefix.empty() ? output : options.temp_prefix);
+    BatchQueue queue(static_cast<size_t>(threads) * 2);
+
+    std::atomic<uint64_t> games{0};
+    std::atomic<uint64_t> skipped{0};
+    std::atomic<uint64_t> positions{0};
+    std::mutex error_mutex;
+    std::string first_error;
+
+    auto work = [&]() {
+        Batch batch;
+        try {
+            std::vector<Count> counts;
+            counts.reserve(run_capacity);
+            std::vector<Count> game_counts;
+            pgn::GameRecord record;
+            Board board;
+            while (queue.pop(batch)) {
+                std::istringstream in(batch.text);
+                pgn::Reader reader(in);
+                while (true) {
+                    try {
+                        if (!reader.next(record)) break;
+                        int white_result;  // 1 win, 0 draw, -1 loss, for white
+                        if (record.result == "1-0") white_result = 1;
+                        else if (record.result == "0-1") white_result = -1;
+                        else if (record.result == "1/2-1/2") white_result = 0;
+                        else { ++skipped; continue; }
+
+                        // Later moves are not replayed at all
+                        if (record.moves.size() > static_cast<size_t>(options.max_ply)) record.moves.resize(options.max_ply);
+                        game_counts.clear();
+                        pgn::for_each_position(record, board, [&](const Board& position, const Move& move) {
+                            const int result = position.is_white_to_move() ? white_result : -white_result;
+                            game_counts.push_back(Count{position.get_hash(), encode_move(move), 1,
+                                                        result > 0 ? 1u : 0u, result == 0 ? 1u : 0u});
+                        });
+                        ++games;
+                        positions += game_counts.size();
+                        counts.insert(counts.end(), game_counts.begin(), game_counts.end());
+                        if (counts.size() >= run_capacity) {
+                            collapse(counts);
+                            runs.write(counts);
+                            counts.clear();
+                        }
+                    } catch (const std::runtime_error&) {
+                        ++skipped;  // bad PGN or illegal move: only this game is lost
+                    }
+                }
+            }
+            if (!counts.empty()) {
+                collapse(counts);
+                runs.write(counts);
+            }
+        } catch (const std::exception& ex) {
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (first_error.empty()) first_error = ex.what();
+            }
+            while (queue.pop(batch)) {}  // keep the splitter from blocking on a full queue
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) workers.emplace_back(work);
+    try {
+        split_archives(pgn_paths, options.batch_games, queue);
+    } catch (const std::exception& ex) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        first_error = ex.what();
+    }
+    queue.close();
+    for (auto& worker : workers) worker.join();
+    if (!first_error.empty()) throw std::runtime_error(first_error);
+
+    BuildStats stats;
+    stats.games = games;
+    stats.skipped_games = skipped;
+    stats.positions = positions;
+    stats.runs = runs.paths().size();
+
+    // K-way merge of the runs, collapsing equal (position, move) pairs across runs
+    std::vector<RunReader> readers;
+    readers.reserve(runs.paths().size());
+    for (const std::string& path : runs.paths()) readers.emplace_back(path);
+    auto later = [&](size_t a, size_t b) { return count_less(readers[b].current(), readers[a].current()); };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heap(later);
+    for (size_t i = 0; i < readers.size(); ++i) {
+        if (!readers[i].done()) heap.push(i);
+    }
+
+    Writer writer(output);
+    std::vector<Count> position_moves;  // all moves of the position being merged
+    while (!heap.empty()) {
+        const size_t i = heap.top();
+        heap.pop();
+        const Count next = readers[i].current();
+        readers[i].advance();
+        if (!readers[i].done()) heap.push(i);
+
+        if (!position_moves.empty() && same_move(position_moves.back(), next)) {
+            add(position_moves.back(), next);
+            continue;
+        }
+        if (!position_moves.empty() && position_moves.back().key != next.key) {
+            write_position(position_moves, options.min_games, writer, stats);
+            position_moves.clear();
+        }
+        position_moves.push_back(next);
+    }
+    if (!position_moves.empty()) write_position(position_moves, options.min_games, writer, stats);
+    writer.finish();
+    return stats;
+}
+
+} // namespace book
+
+#endif // BOOK_BUILDER_H
@@ -34,8 +34,19 @@ static void announce_outcome(const Game& game) {
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
     Game game;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--fen" && i + 1 < argc) {
+            try {
+                game.load_fen(argv[++i]);
+            } catch (const std::exception& ex) {
+                std::cerr << ex.what() << "\n";
+                return 1;
+            }
+        }
+    }
 
     while (true) {
         if (game.status() != GameStatus::Ongoing) {
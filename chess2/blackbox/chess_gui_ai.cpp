@@ -8,6 +8,7 @@
 #include <filesystem>
 #include <system_error>
 #include <exception>
+#include <memory>
 #if defined(__APPLE__)
 #include <mach-o/dyld.h>
 #include <limits.h>
@@ -31,6 +32,7 @@
 #include "material.h"
 #include "lost_pieces.h"
 #include "dfs.h"
+#include "background_search.h"
 
 namespace fs = std::filesystem;
 
@@ -465,8 +467,11 @@ int main(int argc, char** argv) {
     Game game;
     constexpr bool AI_PLAYS_WHITE = false;
     constexpr bool HUMAN_PLAYS_WHITE = !AI_PLAYS_WHITE;
-    DFS dfs_agent(make_material_oracle(), AI_PLAYS_WHITE);
+    Oracle oracle = make_material_oracle();
+    std::shared_ptr<const book::OpeningBook> opening_book;
+    std::shared_ptr<const tablebase::Tablebase> tablebases;
     DFS::MAX_DEPTH = 2;
+    bool ponder = false;
     if (argc > 1) {
         for (int i = 1; i < argc; ++i) {
             std::string arg = argv[i];
@@ -476,10 +481,39 @@ int main(int argc, char** argv) {
                 } catch (const std::exception&) {
                     std::cerr << "Invalid depth value; using default " << DFS::MAX_DEPTH << "\n";
                 }
+            } else if (arg == "--ponder") {
+                ponder = true;
+            } else if (arg == "--structural") {
+                oracle = make_structural_oracle();
+            } else if (arg == "--nnue" && i + 1 < argc) {
+                try {
+                    oracle = make_nnue_oracle(nnue::Network::load(argv[++i]));
+                } catch (const std::exception& ex) {
+                    std::cerr << ex.what() << "; using the material oracle\n";
+                }
+            } else if (arg == "--book" && i + 1 < argc) {
+                try {
+                    opening_book = book::OpeningBook::open(argv[++i]);
+                } catch (const std::exception& ex) {
+                    std::cerr << ex.what() << "; playing without a book\n";
+                }
+            } else if (arg == "--tablebases" && i + 1 < argc) {
+                try {
+                    tablebases = tablebase::Tablebase::open(argv[++i]);
+                } catch (const std::exception& ex) {
+                    std::cerr << ex.what() << "; playing without tablebases\n";
+                }
             }
         }
     }
+    DFS dfs_agent(std::move(oracle), AI_PLAYS_WHITE);
+    if (opening_book) dfs_agent.set_book(opening_book);
+    if (tablebases) dfs_agent.set_tablebase(tablebases);
     bool ai_pending_move = false;
+    std::unique_ptr<BackgroundSearch> ai_search;  // set while the AI is thinking
+    bool ai_pondering = false;                     // ai_search is on the position after the expected reply
+    uint64_t ponder_hash = 0;
+    int ponder_halfmove_clock = 0;
 
     // Load piece textures
     PieceTextures piece_textures = load_piece_textures();
@@ -552,6 +586,8 @@ int main(int argc, char** argv) {
     };
 
     auto reset_game_state = [&]() {
+        ai_search.reset();
+        ai_pondering = false;
         game.reset();
         clear_interaction_state();
         game_over_status = GameStatus::Ongoing;
@@ -590,6 +626,8 @@ int main(int argc, char** argv) {
         return true;
     };
     auto undo_last_move = [&]() -> bool {
+        ai_search.reset();
+        ai_pondering = false;
         bool moved = false;
         do {
             if (!undo_single_move()) break;
@@ -603,6 +641,8 @@ int main(int argc, char** argv) {
         return true;
     };
     auto redo_last_move = [&]() -> bool {
+        ai_search.reset();
+        ai_pondering = false;
         bool moved = false;
         do {
             if (!redo_single_move()) break;
@@ -782,6 +822,23 @@ int main(int argc, char** argv) {
         return ok;
     };
 
+    // Search the position after the reply the last search expects, while the human thinks.
+    auto start_pondering = [&]() {
+        const std::optional<Move>& expected = dfs_agent.ponder_move();
+        if (!expected.has_value()) return;
+        Lawyer& lawyer = Lawyer::instance();
+        if (!lawyer.legal(game.board(), expected.value())) return;
+        Board guess = game.board();
+        lawyer.perform_legal_move(guess, expected.value());
+        const int halfmove_clock =
+            expected->is_attempted_capture_or_pawn_move() ? 0 : game.get_halfmove_clock() + 1;
+        if (lawyer.game_status(guess, {}, halfmove_clock) != GameStatus::Ongoing) return;
+        ponder_hash = guess.get_hash();
+        ponder_halfmove_clock = halfmove_clock;
+        ai_search = std::make_unique<BackgroundSearch>(dfs_agent, guess, halfmove_clock);
+        ai_pondering = true;
+    };
+
     while (!WindowShouldClose()) {
 
         int mx = GetMouseX();
@@ -959,17 +1016,33 @@ int main(int argc, char** argv) {
             } else if (game.board().is_white_to_move() != AI_PLAYS_WHITE) {
                 ai_pending_move = false;
             } else {
-                try {
-                    Move ai_move = dfs_agent.explore(game.board(), game.get_halfmove_clock());
-                    const int ai_result = make_move_and_play_sound(ai_move);
-                    if (ai_result != 0) {
+                if (ai_pondering) {
+                    // Ponder hit: the search already running is the one we need
+                    ai_pondering = false;
+                    if (game.board().get_hash() != ponder_hash || game.get_halfmove_clock() != ponder_halfmove_clock) {
+                        ai_search.reset();
+                    }
+                }
+                if (!ai_search) {
+                    ai_search = std::make_unique<BackgroundSearch>(dfs_agent, game.board(), game.get_halfmove_clock());
+                } else if (ai_search->done()) {
+                    try {
+                        Move ai_move = ai_search->take();
+                        ai_search.reset();
+                        const int ai_result = make_move_and_play_sound(ai_move);
+                        if (ai_result != 0) {
+                            ai_pending_move = false;
+                        } else {
+                            ai_pending_move = (game.board().is_white_to_move() == AI_PLAYS_WHITE);
+                            if (ponder && !ai_pending_move && game.status() == GameStatus::Ongoing) {
+                                start_pondering();
+                            }
+                        }
+                    } catch (const std::exception& ex) {
+                        std::cerr << "AI move failed: " << ex.what() << std::endl;
+                        ai_search.reset();
                         ai_pending_move = false;
-                    } else {
-                        ai_pending_move = (game.board().is_white_to_move() == AI_PLAYS_WHITE);
                     }
-                } catch (const std::exception& ex) {
-                    std::cerr << "AI move failed: " << ex.what() << std::endl;
-                    ai_pending_move = false;
                 }
             }
         }
@@ -1121,9 +1194,16 @@ int main(int argc, char** argv) {
                     + square_utils::square_to_string(ep.get_x(), ep.get_y());
             }
 
+            std::vector<std::string> infoLines{castlingText, enPassantText};
+            if (ai_search) {
+                infoLines.push_back(ai_pondering ? "Pondering..." : "Thinking...");
+                infoLines.push_back("Depth: " + std::to_string(ai_search->depth()) + "/" + std::to_string(DFS::MAX_DEPTH));
+                infoLines.push_back("Nodes: " + std::to_string(ai_search->nodes()));
+            }
+
             const int infoFont = 18;
             const float lineSpacing = 8.0f;
-            const float totalTextHeight = infoFont * 2 + lineSpacing;
+            const float totalTextHeight = infoFont * infoLines.size() + lineSpacing * (infoLines.size() - 1);
             float textY = infoRect.y + (infoRect.height - totalTextHeight) * 0.5f;
 
             auto draw_centered_text = [&](const std::string& text) {
@@ -1133,8 +1213,9 @@ int main(int argc, char** argv) {
                 textY += infoFont + lineSpacing;
             };
 
-            draw_centered_text(castlingText);
-            draw_centered_text(enPassantText);
+            for (const std::string& line : infoLines) {
+                draw_centered_text(line);
+            }
         }
 
         // Chessboard background
@@ -1245,6 +1326,7 @@ int main(int argc, char** argv) {
         EndDrawing();
     }
 
+    ai_search.reset();
     if (pending_move) {
         delete pending_move;
         pending_move = nullptr;
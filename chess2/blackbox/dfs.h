@@ -1,14 +1,22 @@
 #ifndef DFS_H
 #define DFS_H
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <limits>
+#include <memory>
 #include <optional>
+#include <random>
 #include <vector>
 #include "board.h"
 #include "board_print.h"
 #include "lawyer.h"
 #include "move.h"
+#include "opening_book.h"
 #include "oracle.h"
+#include "tablebase.h"
 
 /*
 * Class DFS.
@@ -18,69 +26,222 @@
 * A score of +infty means our player (white if white, else black) is winning.
 * This is in contrast with the Oracle, which always returns the score from
 * white's perspective, as is standard in sites like Chess.com.
+*
+* Nodes one ply above MAX_DEPTH expand all their children first and hand the
+* non-terminal ones to Oracle::evaluate_batch in a single call.
+*
+* With an opening book set, positions found in the book are answered from it
+* without searching. With tablebases set, positions they cover get their exact
+* score instead of being searched or evaluated, and a covered root is answered
+* with the best move straight from the tables.
+*
+* explore() with a SearchControl deepens one ply at a time up to max_depth(),
+* reporting progress as it goes, and can be stopped from another thread; it then
+* answers with the best move of the deepest finished iteration. Each finished
+* iteration is also handed to SearchControl::on_iteration, if set. A
+* SearchControl::deadline stops the search the same way once it passes.
+*
+* After a search that reached depth 2, ponder_move() is the reply the search
+* expects from the opponent, so the next position can be searched on their time.
 */
 
+// A finished iteration of a controlled search.
+struct Iteration {
+    int depth;
+    double score;  // from the searching agent's perspective
+    std::vector<Move> pv;  // best move, then the expected reply if the search looked that far
+    uint64_t nodes;  // searched so far, all iterations included
+};
+
+// Progress of a search, shared with the thread that may stop it.
+struct SearchControl {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> nodes{0};
+    std::atomic<int> depth{0};  // deepest finished iteration
+    std::function<void(const Iteration&)> on_iteration;  // called on the searching thread
+    std::optional<std::chrono::steady_clock::time_point> deadline;  // set before the search starts
+};
+
 class DFS {
 public:
     static int MAX_DEPTH;
+    static constexpr double TABLEBASE_WIN = 1e6;
 
     explicit DFS(Oracle oracle, bool white)
         : oracle_(std::move(oracle)), white_(white) {}
 
+    // Answer book positions from `book` (nullptr to stop). `seed` drives the weighted choice between book moves.
+    void set_book(std::shared_ptr<const book::OpeningBook> book, uint64_t seed = std::random_device{}()) {
+        book_ = std::move(book);
+        book_rng_.seed(seed);
+    }
+
+    // Score positions covered by `tablebase` exactly (nullptr to stop).
+    void set_tablebase(std::shared_ptr<const tablebase::Tablebase> tablebase) {
+        tablebase_ = std::move(tablebase);
+    }
+
+    // Search this agent `depth` plies deep instead of MAX_DEPTH (0 to follow MAX_DEPTH again).
+    void set_max_depth(int depth) { max_depth_ = depth; }
+    int max_depth() const { return max_depth_ > 0 ? max_depth_ : MAX_DEPTH; }
+
+    // Expected reply to the move of the last explore, if the search looked that far.
+    const std::optional<Move>& ponder_move() const { return ponder_move_; }
+
     Move explore(const Board& root, int halfmove_clock = 0) {
         // Notice `white` and `root.is_white_to_move()` need not coincide.
+        ponder_move_.reset();
+        if (auto answer = answer_without_search(root, halfmove_clock)) return answer.value();
+        Board prepared = root;
+        oracle_.prepare(prepared);
+        control_ = nullptr;
+        depth_limit_ = max_depth();
+        auto result = explore_recursive(prepared, 0, halfmove_clock);
+        if (!result.best_move.has_value()) {
+            throw std::runtime_error("DFS::explore failed to find any legal move, board should've been caught as terminal");
+        }
+        if (result.reply.has_value()) ponder_move_.emplace(result.reply.value());
+        return result.best_move.value();
+    }
+
+    // Iterative deepening up to max_depth(), counting nodes into `control` and
+    // giving up once control.stop is set. Throws if stopped before depth 1 finishes.
+    Move explore(const Board& root, int halfmove_clock, SearchControl& control) {
+        ponder_move_.reset();
+        if (auto answer = answer_without_search(root, halfmove_clock)) {
+            control.depth.store(max_depth(), std::memory_order_relaxed);
+            return answer.value();
+        }
+        Board prepared = root;
+        oracle_.prepare(prepared);
+        control_ = &control;
+        struct Release {
+            DFS& dfs;
+            ~Release() { dfs.control_ = nullptr; }
+        } release{*this};
+        std::optional<Move> best;
+        const int max_depth = this->max_depth();
+        for (int depth = 1; depth <= max_depth; ++depth) {
+            depth_limit_ = depth;
+            auto result = explore_recursive(prepared, 0, halfmove_clock);
+            if (stopped()) break;
+            if (!result.best_move.has_value()) {
+                throw std::runtime_error("DFS::explore failed to find any legal move, board should've been caught as terminal");
+            }
+            best.emplace(result.best_move.value());
+            ponder_move_.reset();
+            if (result.reply.has_value()) ponder_move_.emplace(result.reply.value());
+            control.depth.store(depth, std::memory_order_relaxed);
+            if (control.on_iteration) {
+                Iteration iteration{depth, result.score, {result.best_move.value()},
+                                    control.nodes.load(std::memory_order_relaxed)};
+                if (result.reply.has_value()) iteration.pv.push_back(result.reply.value());
+                control.on_iteration(iteration);
+            }
+        }
+        if (!best.has_value()) throw std::runtime_error("DFS::explore was stopped before finishing depth 1");
+        return best.value();
+    }
+
+private:
+    // Book or tablebase move at the root, if there is one
+    std::optional<Move> answer_without_search(const Board& root, int halfmove_clock) {
         Lawyer& lawyer = Lawyer::instance();
         GameStatus status = lawyer.game_status(root, {}, halfmove_clock);
         if (status != GameStatus::Ongoing) {
             throw std::runtime_error("DFS::explore called on terminal board");
         }
-        auto result = explore_recursive(root, 0, halfmove_clock);
-        if (!result.best_move.has_value()) {
-            throw std::runtime_error("DFS::explore failed to find any legal move, board should've been caught as terminal");
+        if (book_) {
+            if (auto book_move = book_->probe(root, book_rng_())) return book_move;
         }
-        return result.best_move.value();
+        return tablebase_root_move(root, halfmove_clock);
+    }
+
+    bool stopped() const {
+        if (control_ == nullptr) return false;
+        if (control_->stop.load(std::memory_order_relaxed)) return true;
+        if (control_->deadline.has_value() && std::chrono::steady_clock::now() >= control_->deadline.value()) {
+            control_->stop.store(true, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void count_nodes(uint64_t count) const {
+        if (control_ != nullptr) control_->nodes.fetch_add(count, std::memory_order_relaxed);
     }
 
-private:
     struct NodeResult {
         std::optional<Move> best_move;
         double score = -std::numeric_limits<double>::infinity();  // Score from our guy's perspective.
+        std::optional<Move> reply;  // At the root: best move of the child reached by best_move, if searched
     };
 
-    NodeResult explore_recursive(const Board& board, int depth, int halfmove_clock) const {
-        Lawyer& lawyer = Lawyer::instance();
-        GameStatus status = lawyer.game_status(board, {}, halfmove_clock);
+    // Score of a finished game, from our guy's perspective
+    double terminal_score(const Board& board, GameStatus status) const {
+        if (status == GameStatus::Checkmate) {
+            const double score = std::numeric_limits<double>::infinity();
+            return (white_ == board.is_white_to_move()) ? -score : score;
+        } else if (status == GameStatus::ThreefoldRepetition) {
+            throw std::runtime_error("DFS found a 3-fold repetition draw");
+        }
+        return 0.0;  // Stalemate or FiftyMoveRule
+    }
 
-        if (status != GameStatus::Ongoing) {
-            double terminal_score = 0.0;
-            if (status == GameStatus::Checkmate) {
-                terminal_score = std::numeric_limits<double>::infinity();
-                if (white_ == board.is_white_to_move()) terminal_score *= -1;
-            } else if (status == GameStatus::Stalemate || status == GameStatus::FiftyMoveRule) {
-                terminal_score = 0.0;
-            } else if (status == GameStatus::ThreefoldRepetition) {
-                throw std::runtime_error("DFS found a 3-fold repetition draw");
+    // Exact score of a position in the tablebases, from our guy's perspective.
+    // Tablebase wins rank below mates found in the tree and prefer the shortest mate.
+    std::optional<double> tablebase_score(const Board& board) const {
+        if (!tablebase_ || board.get_piece_count() > tablebase_->max_pieces()) return std::nullopt;
+        const auto code = tablebase_->probe(board);
+        if (!code.has_value() || code.value() == tablebase::INVALID) return std::nullopt;
+        if (code.value() == tablebase::DRAW) return 0.0;
+        const int plies = tablebase::plies_to_mate(code.value());
+        const double mover_score = tablebase::is_win(code.value()) ? TABLEBASE_WIN - plies : -(TABLEBASE_WIN - plies);
+        return (board.is_white_to_move() == white_) ? mover_score : -mover_score;
+    }
+
+    // Best move at a root covered by the tablebases, if every child is covered too.
+    std::optional<Move> tablebase_root_move(const Board& root, int halfmove_clock) const {
+        if (!tablebase_ || root.get_piece_count() > tablebase_->max_pieces() || !tablebase_score(root).has_value()) {
+            return std::nullopt;
+        }
+        Lawyer& lawyer = Lawyer::instance();
+        const int direction = (root.is_white_to_move() == white_) ? 1 : -1;
+        std::optional<Move> best;
+        double best_score = 0.0;
+        for (const Child& child : expand(root, halfmove_clock)) {
+            double score;
+            const GameStatus status = lawyer.game_status(child.board, {}, child.halfmove_clock);
+            if (status != GameStatus::Ongoing) {
+                score = terminal_score(child.board, status);
+            } else if (auto exact = tablebase_score(child.board)) {
+                score = exact.value();
+            } else {
+                return std::nullopt;
+            }
+            if (!best.has_value() || direction * score > direction * best_score) {
+                best.emplace(child.move);
+                best_score = score;
             }
-            return NodeResult{std::nullopt, terminal_score};
         }
+        return best;
+    }
 
-        if (depth == MAX_DEPTH) {
-            double score = oracle_.evaluate(board);
-            if (!white_) score *= -1;  // Oracle always evaluates for white.
-            // if (score > 0)
-            //     std::cout << "\n========================\nScore for terminal board\n" << board << "is: " << score << std::endl;
-            return NodeResult{std::nullopt, score};
-        } else if (depth > MAX_DEPTH) {
-            throw std::runtime_error("DFS went over its MAX_DEPTH");
-        }
+    // A legal child of the current node
+    struct Child {
+        Move move;
+        Board board;
+        int halfmove_clock;
+    };
 
+    // Call visit(move, next_board, next_halfmove_clock) for every legal move from `board`. Each
+    // child board lives only for its call (visit may take it over), so interior nodes that
+    // recurse from visit hold one board per ply.
+    template <typename Visitor>
+    void for_each_child(const Board& board, int halfmove_clock, Visitor&& visit) const {
+        Lawyer& lawyer = Lawyer::instance();
         const int piece_count = board.get_piece_count();
         const bool white_to_move = board.is_white_to_move();
-
-        NodeResult mercurial;  // Best move for us if it's our guy's turn, else it's the worst move for us.
-        int direction = (board.is_white_to_move() == white_) ? 1 : -1;
-        mercurial.score = -direction * std::numeric_limits<double>::infinity();
-
         for (int idx = 0; idx < piece_count; ++idx) {
             const Piece& piece = board.get_piece(idx);
             if (piece.white != white_to_move) continue;
@@ -96,18 +257,110 @@ private:
                 }
                 if (!lawyer.legal(board, move)) continue;
                 Board next = board;
-                lawyer.perform_move(next, move);
+                lawyer.perform_legal_move(next, move);
                 const int next_halfmove = move.is_attempted_capture_or_pawn_move() ? 0 : (halfmove_clock + 1);
-                auto child = explore_recursive(next, depth + 1, next_halfmove);
+                visit(static_cast<const Move&>(move), next, next_halfmove);
+            }
+        }
+    }
 
-                if (direction * child.score >= direction * mercurial.score) {
-                    // This breaks ties in the case of mate-in-1, where every score is -infty
-                    mercurial.score = child.score;
-                    mercurial.best_move.emplace(move);
-                }
+    // Every legal child of `board` at once, for nodes that score their children together.
+    std::vector<Child> expand(const Board& board, int halfmove_clock) const {
+        std::vector<Child> children;
+        for_each_child(board, halfmove_clock, [&](const Move& move, Board& next, int next_halfmove) {
+            children.push_back(Child{move, std::move(next), next_halfmove});
+        });
+        return children;
+    }
+
+    // Node one ply above the depth limit: every child is a leaf, so score them all with one batch call.
+    NodeResult explore_frontier(const Board& board, int halfmove_clock) const {
+        Lawyer& lawyer = Lawyer::instance();
+        const std::vector<Child> children = expand(board, halfmove_clock);
+        count_nodes(children.size());
+
+        std::vector<double> scores(children.size());
+        std::vector<const Board*> leaves;
+        std::vector<size_t> leaf_child;  // leaves[i] is children[leaf_child[i]].board
+        leaves.reserve(children.size());
+        leaf_child.reserve(children.size());
+        for (size_t i = 0; i < children.size(); ++i) {
+            const GameStatus status = lawyer.game_status(children[i].board, {}, children[i].halfmove_clock);
+            if (status != GameStatus::Ongoing) {
+                scores[i] = terminal_score(children[i].board, status);
+                continue;
+            }
+            if (auto exact = tablebase_score(children[i].board)) {
+                scores[i] = exact.value();
+                continue;
             }
+            leaves.push_back(&children[i].board);
+            leaf_child.push_back(i);
         }
 
+        std::vector<double> evaluations(leaves.size());
+        oracle_.evaluate_batch(leaves.data(), evaluations.data(), leaves.size());
+        for (size_t i = 0; i < leaves.size(); ++i) {
+            // Oracle always evaluates for white.
+            scores[leaf_child[i]] = white_ ? evaluations[i] : -evaluations[i];
+        }
+
+        NodeResult mercurial;
+        const int direction = (board.is_white_to_move() == white_) ? 1 : -1;
+        mercurial.score = -direction * std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < children.size(); ++i) {
+            if (direction * scores[i] >= direction * mercurial.score) {
+                mercurial.score = scores[i];
+                mercurial.best_move.emplace(children[i].move);
+            }
+        }
+        if (!mercurial.best_move.has_value()) {
+            throw std::runtime_error("No best move found in DFS::explore_frontier()");
+        }
+        return mercurial;
+    }
+
+    NodeResult explore_recursive(const Board& board, int depth, int halfmove_clock) const {
+        if (stopped()) return NodeResult{std::nullopt, 0.0, std::nullopt};  // the caller throws this iteration away
+        count_nodes(1);
+        Lawyer& lawyer = Lawyer::instance();
+        GameStatus status = lawyer.game_status(board, {}, halfmove_clock);
+
+        if (status != GameStatus::Ongoing) {
+            return NodeResult{std::nullopt, terminal_score(board, status), std::nullopt};
+        }
+        if (depth > 0) {
+            if (auto exact = tablebase_score(board)) return NodeResult{std::nullopt, exact.value(), std::nullopt};
+        }
+
+        if (depth == depth_limit_ - 1) {
+            return explore_frontier(board, halfmove_clock);
+        } else if (depth == depth_limit_) {
+            double score = oracle_.evaluate(board);
+            if (!white_) score *= -1;  // Oracle always evaluates for white.
+            // if (score > 0)
+            //     std::cout << "\n========================\nScore for terminal board\n" << board << "is: " << score << std::endl;
+            return NodeResult{std::nullopt, score, std::nullopt};
+        } else if (depth > depth_limit_) {
+            throw std::runtime_error("DFS went over its MAX_DEPTH");
+        }
+
+        NodeResult mercurial;  // Best move for us if it's our guy's turn, else it's the worst move for us.
+        int direction = (board.is_white_to_move() == white_) ? 1 : -1;
+        mercurial.score = -direction * std::numeric_limits<double>::infinity();
+
+        for_each_child(board, halfmove_clock, [&](const Move& move, const Board& next, int next_halfmove) {
+            auto child = explore_recursive(next, depth + 1, next_halfmove);
+
+            if (direction * child.score >= direction * mercurial.score) {
+                // This breaks ties in the case of mate-in-1, where every score is -infty
+                mercurial.score = child.score;
+                mercurial.best_move.emplace(move);
+                mercurial.reply.reset();
+                if (depth == 0 && child.best_move.has_value()) mercurial.reply.emplace(child.best_move.value());
+            }
+        });
+
         if (!mercurial.best_move.has_value()) {
             throw std::runtime_error("No best move found in DFS::explore_recursive()");
         }
@@ -117,6 +370,13 @@ private:
 
     const Oracle oracle_;
     const bool white_;
+    std::shared_ptr<const book::OpeningBook> book_;
+    std::shared_ptr<const tablebase::Tablebase> tablebase_;
+    std::mt19937_64 book_rng_;
+    SearchControl* control_ = nullptr;  // set while a controlled search runs
+    std::optional<Move> ponder_move_;
+    int depth_limit_ = 0;
+    int max_depth_ = 0;
 };
 
 inline int DFS::MAX_DEPTH = 3;
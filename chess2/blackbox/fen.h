@@ -0,0 +1,246 @@
+#ifndef FEN_H
+#define FEN_H
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "board.h"
+#include "square_utils.h"
+
+/*
+* Forsyth-Edwards Notation import/export.
+*
+* "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1"
+*  placement (rank 8 first)  side  castling  en-passant  halfmove clock  fullmove number
+*
+* Parsing is strict: all six fields are required and the position must make sense
+* for the rest of the engine (one king each, no pawns on the back ranks, castling
+* rights backed by an unmoved king and rook, a real en-passant pawn, and the side
+* that just moved not in check). Anything else throws std::runtime_error.
+*
+* Both directions work on caller-owned objects (parse into an existing Board,
+* append to an existing string), so loading many positions does not allocate
+* once the buffers have grown.
+*/
+
+namespace fen {
+
+inline constexpr const char* STARTING_POSITION = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+namespace fen_detail {
+
+[[noreturn]] inline void fail(const char* what, std::string_view text) {
+    throw std::runtime_error(std::string("Invalid FEN (") + what + "): " + std::string(text));
+}
+
+// Split off the next space-separated field. Exactly one space between fields.
+inline std::string_view next_field(std::string_view& rest, std::string_view text) {
+    if (rest.empty()) fail("missing field", text);
+    const size_t space = rest.find(' ');
+    std::string_view field = rest.substr(0, space);
+    if (field.empty()) fail("empty field", text);
+    rest = (space == std::string_view::npos) ? std::string_view{} : rest.substr(space + 1);
+    if (space != std::string_view::npos && rest.empty()) fail("trailing space", text);
+    return field;
+}
+
+inline int parse_counter(std::string_view field, std::string_view text) {
+    if (field.size() > 6) fail("counter too large", text);
+    int value = 0;
+    for (char c : field) {
+        if (c < '0' || c > '9') fail("counter is not a number", text);
+        value = value * 10 + (c - '0');
+    }
+    return value;
+}
+
+inline bool piece_is(const Board& board, int x, int y, PieceKind kind, bool white) {
+    const int idx = board.find_piece_at(x, y);
+    if (idx == -1) return false;
+    const Piece& p = board.get_piece(idx);
+    return p.kind == kind && p.white == white;
+}
+
+} // namespace fen_detail
+
+// Parse `text` into `board`, replacing its contents.
+inline void parse(std::string_view text, Board& board, int& halfmove_clock, int& fullmove_number) {
+    using namespace fen_detail;
+    std::string_view rest = text;
+    const std::string_view placement = next_field(rest, text);
+    const std::string_view side = next_field(rest, text);
+    const std::string_view castling = next_field(rest, text);
+    const std::string_view en_passant = next_field(rest, text);
+    const std::string_view halfmove = next_field(rest, text);
+    const std::string_view fullmove = next_field(rest, text);
+    if (!rest.empty()) fail("too many fields", text);
+
+    board.clear();
+
+    // Piece placement
+    int x = 0;
+    int y = 7;
+    bool last_was_digit = false;
+    int kings[2] = {0, 0};
+    int pawns[2] = {0, 0};
+    int totals[2] = {0, 0};
+    for (char c : placement) {
+        if (c == '/') {
+            if (x != 8) fail("rank does not have 8 squares", text);
+            if (y == 0) fail("more than 8 ranks", text);
+            --y;
+            x = 0;
+            last_was_digit = false;
+        } else if (c >= '1' && c <= '8') {
+            if (last_was_digit) fail("consecutive digits", text);
+            x += c - '0';
+            if (x > 8) fail("rank has more than 8 squares", text);
+            last_was_digit = true;
+        } else {
+            const bool white = (c >= 'A' && c <= 'Z');
+            const char upper = white ? c : static_cast<char>(c - 'a' + 'A');
+            PieceKind kind;
+            switch (upper) {
+                case 'K': case 'Q': case 'R': case 'B': case 'N': case 'P':
+                    kind = char_to_kind(upper);
+                    break;
+                default:
+                    fail("unknown piece letter", text);
+            }
+            if (x >= 8) fail("rank has more than 8 squares", text);
+            const int side_idx = white ? 0 : 1;
+            if (kind == PieceKind::King) ++kings[side_idx];
+            if (kind == PieceKind::Pawn) {
+                if (y == 0 || y == 7) fail("pawn on a back rank", text);
+                ++pawns[side_idx];
+            }
+            ++totals[side_idx];
+            board.place_piece(Piece(x, y, white, kind));
+            ++x;
+            last_was_digit = false;
+        }
+    }
+    if (y != 0 || x != 8) fail("placement does not cover 8 ranks", text);
+    if (kings[0] != 1 || kings[1] != 1) fail("each side needs exactly one king", text);
+    if (pawns[0] > 8 || pawns[1] > 8 || totals[0] > 16 || totals[1] > 16) fail("too many pieces", text);
+
+    // Side to move
+    if (side == "w") {
+        board.set_white_to_move(true);
+    } else if (side == "b") {
+        board.set_white_to_move(false);
+    } else {
+        fail("side to move must be w or b", text);
+    }
+    const bool white_to_move = board.is_white_to_move();
+
+    // Castling rights, in KQkq order
+    CastlingRights cr;
+    if (castling != "-") {
+        const char order[4] = {'K', 'Q', 'k', 'q'};
+        int next = 0;
+        for (char c : castling) {
+            while (next < 4 && order[next] != c) ++next;
+            if (next == 4) fail("castling rights out of order or unknown", text);
+            ++next;
+            switch (c) {
+                case 'K': cr.white_kingside = true; break;
+                case 'Q': cr.white_queenside = true; break;
+                case 'k': cr.black_kingside = true; break;
+                case 'q': cr.black_queenside = true; break;
+            }
+        }
+        const bool white_king_home = piece_is(board, 4, 0, PieceKind::King, true);
+        const bool black_king_home = piece_is(board, 4, 7, PieceKind::King, false);
+        if (cr.white_kingside && !(white_king_home && piece_is(board, 7, 0, PieceKind::Rook, true))) fail("castling right K without king and rook", text);
+        if (cr.white_queenside && !(white_king_home && piece_is(board, 0, 0, PieceKind::Rook, true))) fail("castling right Q without king and rook", text);
+        if (cr.black_kingside && !(black_king_home && piece_is(board, 7, 7, PieceKind::Rook, false))) fail("castling right k without king and rook", text);
+        if (cr.black_queenside && !(black_king_home && piece_is(board, 0, 7, PieceKind::Rook, false))) fail("castling right q without king and rook", text);
+    }
+    board.set_castling(cr);
+
+    // En passant target: the square the double-stepping pawn skipped
+    if (en_passant != "-") {
+        if (en_passant.size() != 2) fail("bad en-passant square", text);
+        const int ex = en_passant[0] - 'a';
+        const int ey = en_passant[1] - '1';
+        const int expected_y = white_to_move ? 5 : 2;
+        if (ex < 0 || ex > 7 || ey != expected_y) fail("bad en-passant square", text);
+        const int pawn_y = white_to_move ? 4 : 3;
+        const int origin_y = white_to_move ? 6 : 1;
+        if (!piece_is(board, ex, pawn_y, PieceKind::Pawn, !white_to_move)) fail("no pawn to capture en passant", text);
+        if (board.find_piece_at(ex, ey) != -1 || board.find_piece_at(ex, origin_y) != -1) fail("en-passant path not empty", text);
+        board.set_en_passant(EnPassant(ex, ey, white_to_move ? EnPassantVulnerable::Black : EnPassantVulnerable::White));
+    }
+
+    halfmove_clock = parse_counter(halfmove, text);
+    fullmove_number = parse_counter(fullmove, text);
+    if (fullmove_number < 1) fail("fullmove number must be positive", text);
+
+    if (board.is_player_in_check(!white_to_move)) fail("side not to move is in check", text);
+}
+
+// Convenience overload returning a fresh board.
+inline Board parse(std::string_view text, int& halfmove_clock, int& fullmove_number) {
+    Board board;
+    parse(text, board, halfmove_clock, fullmove_number);
+    return board;
+}
+
+// Append the FEN of `board` to `out`.
+inline void write(const Board& board, int halfmove_clock, int fullmove_number, std::string& out) {
+    for (int y = 7; y >= 0; --y) {
+        int empty = 0;
+        for (int x = 0; x < 8; ++x) {
+            const int idx = board.find_piece_at(x, y);
+            if (idx == -1) {
+                ++empty;
+                continue;
+            }
+            if (empty > 0) out.push_back(static_cast<char>('0' + empty));
+            empty = 0;
+            const Piece& p = board.get_piece(idx);
+            const char c = kind_to_char(p.kind);
+            out.push_back(p.white ? c : static_cast<char>(c - 'A' + 'a'));
+        }
+        if (empty > 0) out.push_back(static_cast<char>('0' + empty));
+        if (y > 0) out.push_back('/');
+    }
+
+    out.push_back(' ');
+    out.push_back(board.is_white_to_move() ? 'w' : 'b');
+
+    out.push_back(' ');
+    const CastlingRights cr = board.get_castling_rights();
+    const size_t before = out.size();
+    if (cr.white_kingside) out.push_back('K');
+    if (cr.white_queenside) out.push_back('Q');
+    if (cr.black_kingside) out.push_back('k');
+    if (cr.black_queenside) out.push_back('q');
+    if (out.size() == before) out.push_back('-');
+
+    out.push_back(' ');
+    const EnPassant ep = board.get_en_passant();
+    if (ep.is_active()) {
+        out.push_back(square_utils::file_char(ep.get_x()));
+        out.push_back(square_utils::rank_char(ep.get_y()));
+    } else {
+        out.push_back('-');
+    }
+
+    out.push_back(' ');
+    out += std::to_string(halfmove_clock);
+    out.push_back(' ');
+    out += std::to_string(fullmove_number);
+}
+
+inline std::string write(const Board& board, int halfmove_clock = 0, int fullmove_number = 1) {
+    std::string out;
+    out.reserve(90);
+    write(board, halfmove_clock, fullmove_number, out);
+    return out;
+}
+
+} // namespace fen
+
+#endif // FEN_H
@@ -14,6 +14,7 @@
 #include "castling.h"
 #include "lawyer.h"
 #include "move.h"
+#include "fen.h"
 
 struct Game {
 private:
@@ -25,6 +26,12 @@ private:
     int halfmove_clock_ = 0;
     std::vector<int> undo_halfmove_clock_;
     std::vector<int> redo_halfmove_clock_;
+    // Moves played, in step with the undo/redo stacks (undo_moves_[i] was played from undo_stack_[i])
+    std::vector<Move> undo_moves_;
+    std::vector<Move> redo_moves_;
+    // Fullmove number and side to move of the starting position (not always the standard one, see load_fen)
+    int start_fullmove_number_ = 1;
+    bool start_white_to_move_ = true;
 
     // Update Game Status and Game Winner
     void update_outcome(void) {
@@ -42,7 +49,7 @@ private:
 public:
     Game() : board_(), status_(GameStatus::Ongoing), winner_(GameWinner::TBD),
              undo_stack_(), redo_stack_(), halfmove_clock_(0),
-             undo_halfmove_clock_(), redo_halfmove_clock_() {
+             undo_halfmove_clock_(), redo_halfmove_clock_(), undo_moves_(), redo_moves_() {
         board_.reset();
     }
 
@@ -54,11 +61,49 @@ public:
         redo_stack_.clear();
         undo_halfmove_clock_.clear();
         redo_halfmove_clock_.clear();
+        undo_moves_.clear();
+        redo_moves_.clear();
         halfmove_clock_ = 0;
+        start_fullmove_number_ = 1;
+        start_white_to_move_ = true;
     }
 
+    // Start a new game from a FEN position. Throws std::runtime_error if the FEN is invalid,
+    // in which case the current game is left untouched.
+    void load_fen(const std::string& text) {
+        Board loaded;
+        int halfmove_clock = 0;
+        int fullmove_number = 1;
+        fen::parse(text, loaded, halfmove_clock, fullmove_number);
+        reset();
+        board_ = std::move(loaded);
+        halfmove_clock_ = halfmove_clock;
+        start_fullmove_number_ = fullmove_number;
+        start_white_to_move_ = board_.is_white_to_move();
+        update_outcome();
+    }
+
+    // FEN of the current position
+    std::string fen() const {
+        return fen::write(board_, halfmove_clock_, fullmove_number());
+    }
+
+    // Position the game started from (before any move), and its FEN
+    const Board& starting_board() const { return undo_stack_.empty() ? board_ : undo_stack_.front(); }
+    std::string starting_fen() const {
+        const int halfmove_clock = undo_stack_.empty() ? halfmove_clock_ : undo_halfmove_clock_.front();
+        return fen::write(starting_board(), halfmove_clock, start_fullmove_number_);
+    }
+    // Moves played from the starting position up to the current one
+    const std::vector<Move>& moves() const { return undo_moves_; }
+
     const Board& board() const { return board_; }
     int get_halfmove_clock() const { return halfmove_clock_; }
+    // Incremented after each black move, as in FEN
+    int fullmove_number() const {
+        const int plies = (int)undo_stack_.size() + (start_white_to_move_ ? 0 : 1);
+        return start_fullmove_number_ + plies / 2;
+    }
     GameStatus status() const { return status_; }
     GameWinner winner() const { return winner_; }
 
@@ -109,10 +154,12 @@ public:
         // Move OK, let's perform it!
         undo_stack_.push_back(board_);  // Copy board
         undo_halfmove_clock_.push_back(halfmove_clock_);
+        undo_moves_.push_back(attempted);
         Lawyer& lawyer = Lawyer::instance();
-        lawyer.perform_move(board_, attempted);
+        lawyer.perform_legal_move(board_, attempted);  // verified above
         redo_stack_.clear();
         redo_halfmove_clock_.clear();
+        redo_moves_.clear();
         if (attempted.is_attempted_capture_or_pawn_move()) {
             halfmove_clock_ = 0;
         } else {
@@ -141,6 +188,8 @@ public:
         undo_stack_.pop_back();
         halfmove_clock_ = undo_halfmove_clock_.back();
         undo_halfmove_clock_.pop_back();
+        redo_moves_.push_back(undo_moves_.back());
+        undo_moves_.pop_back();
         update_outcome();
         return true;
     }
@@ -156,6 +205,8 @@ public:
         redo_stack_.pop_back();
         halfmove_clock_ = redo_halfmove_clock_.back();
         redo_halfmove_clock_.pop_back();
+        undo_moves_.push_back(redo_moves_.back());
+        redo_moves_.pop_back();
         update_outcome();
         return true;
     }
@@ -7,6 +7,7 @@
 #include <sstream> 
 #include <stdexcept>
 #include <memory>
+#include <vector>
 #include "piece.h"
 #include "board.h"
 #include "move.h"
@@ -37,6 +38,8 @@ enum class GameWinner { White, Black, Draw, TBD };
 * This class is also capacitated to actually PERFORM the moves on a live board.
 * No other part of the code should do this.
 *
+* The Lawyer keeps no mutable state, so it can be used from several threads at once.
+*
 * NOTE:
 * To check for legality, one must check that the king's square after moving,
 * (and the squares it passes through/moves from during castling) are not under attack.
@@ -57,9 +60,6 @@ public:
 
 private:
 
-    // If true, we can perform illegal (but valid) moves. Mostly used for checking legality.
-    bool in_simulation = false;
-
     Lawyer() = default;                    // private constructor
     ~Lawyer() = default;           // private destructor
     Lawyer(const Lawyer&) = delete;      // disable copy
@@ -67,17 +67,12 @@ private:
     Lawyer(Lawyer&&) = delete;           // disable move
     Lawyer& operator=(Lawyer&&) = delete;
 
-public:
-
     /*
-    * Perform a move
+    * Move the pieces without checking legality. Valid but illegal moves are fine here,
+    * which is how legal() simulates a move to see whether it leaves the king in check.
+    * Simulated boards are thrown away, so they skip the NNUE accumulator update.
     */
-    void perform_move(Board& board, const Move& move) {
-        if (!in_simulation) {
-            if (!legal(board, move)) {
-                throw std::runtime_error("Cannot perform illegal move");
-            }
-        }
+    void apply_move(Board& board, const Move& move, const bool simulation) {
         const int fromX = move.from_x();
         const int fromY = move.from_y();
         const int toX = move.to_x();
@@ -89,6 +84,7 @@ public:
         int to_idx = board.find_piece_at(toX, toY);
         const Piece mover = board.get_piece(from_idx);
         CastlingRights cr = board.get_castling_rights();  // copy
+        nnue::FeatureDelta delta;  // pieces removed/added, for the NNUE accumulator
 
         if (move.is_attempted_castling()) {
             const bool kingside = toX > fromX;
@@ -100,6 +96,8 @@ public:
             }
             // King moved later, rook moved now
             board.teletransport_piece(rook_idx, rook_to_x, fromY);
+            delta.remove(PieceKind::Rook, mover.white, rook_from_x, fromY);
+            delta.add(PieceKind::Rook, mover.white, rook_to_x, fromY);
             if (mover.white) {
                 cr.white_kingside = false;
                 cr.white_queenside = false;
@@ -113,11 +111,13 @@ public:
                 throw std::runtime_error("Lawyer::simulate_move: en-passant capture target missing");
             }
             const bool adjust_from = capture_idx < from_idx;
+            delta.remove(PieceKind::Pawn, !mover.white, toX, fromY);
             board.delete_piece(capture_idx);
             if (adjust_from) --from_idx;
         } else if (move.is_attempted_capture() && to_idx != -1) {
             const Piece& captured = board.get_piece(to_idx);
             cr.revoke_for_rook(captured);
+            delta.remove(captured.kind, captured.white, toX, toY);
             const bool adjust_from = to_idx < from_idx;
             board.delete_piece(to_idx);
             if (adjust_from) --from_idx;
@@ -131,6 +131,8 @@ public:
         }
 
         board.teletransport_piece(from_idx, toX, toY);
+        delta.remove(mover.kind, mover.white, fromX, fromY);
+        delta.add(move.is_attempted_promotion() ? move.get_promotion() : mover.kind, mover.white, toX, toY);
 
         if (move.is_attempted_initial_two_square_pawn_move()) {
             const int direction = mover.white ? 1 : -1;
@@ -156,8 +158,29 @@ public:
         board.set_castling(cr);
 
         board.toggle_white_to_move();
+
+        if (!simulation && board.has_accumulator()) {
+            nnue::apply_delta(board.get_accumulator(), delta);
+        }
    }
 
+public:
+
+    /*
+    * Perform a move
+    */
+    void perform_move(Board& board, const Move& move) {
+        if (!legal(board, move)) {
+            throw std::runtime_error("Cannot perform illegal move");
+        }
+        apply_move(board, move, false);
+    }
+
+    // Perform a move the caller has already verified with legal(), without checking it again.
+    void perform_legal_move(Board& board, const Move& move) {
+        apply_move(board, move, false);
+    }
+
 public:
     // Verify if the move is legal
     bool legal(const Board& board, const Move& move) {
@@ -172,11 +195,35 @@ public:
     
         // Simulate the move and see if the player who moved is left in check afterwards
         Board sim = board;
-        in_simulation = true;
-        perform_move(sim, move);
-        const bool output = !(sim.is_player_in_check(move.is_a_white_move()));
-        in_simulation = false;
-        return output;
+        apply_move(sim, move, true);
+        return !(sim.is_player_in_check(move.is_a_white_move()));
+    }
+
+    // Every legal move for the player to move, including each promotion choice.
+    std::vector<Move> legal_moves(const Board& board) {
+        std::vector<Move> moves;
+        const bool white_to_move = board.is_white_to_move();
+        const int piece_count = board.get_piece_count();
+        for (int idx = 0; idx < piece_count; ++idx) {
+            const Piece& mover = board.get_piece(idx);
+            if (mover.white != white_to_move) continue;
+            const auto targets = board.get_targets(idx);
+            for (const auto& target : targets) {
+                Move move(mover.x, mover.y, target.first, target.second, board);
+                if (!move.is_valid()) continue;
+                if (!move.is_attempted_promotion()) {
+                    if (legal(board, move)) moves.push_back(move);
+                    continue;
+                }
+                if (!attempted_promotion_would_be_legal(board, move)) continue;
+                for (PieceKind promo : promoKinds) {
+                    Move candidate = move;
+                    candidate.set_promotion(promo);
+                    moves.push_back(candidate);
+                }
+            }
+        }
+        return moves;
     }
 
     // Verify if an attempted promotion would be legal without actually setting the promotion piece
@@ -245,7 +292,7 @@ public:
             }
             // The following is NOT a simulation, since it still requires legal moves.
             Board hypoth(board);
-            perform_move(hypoth, candidate);
+            perform_legal_move(hypoth, candidate);
             const int next_halfmove = candidate.is_attempted_capture_or_pawn_move() ? 0 : (halfmove_clock + 1);
             return game_status(hypoth, std::vector<Board>{}, next_halfmove) == GameStatus::Checkmate;
         };
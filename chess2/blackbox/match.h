@@ -0,0 +1,380 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "background_search.h"
+#include "board.h"
+#include "dfs.h"
+#include "game.h"
+#include "lawyer.h"
+#include "move.h"
+#include "nnue.h"
+#include "opening_book.h"
+#include "oracle.h"
+#include "pgn.h"
+#include "tablebase.h"
+#include "uci.h"
+
+/*
+* Self-play matches between two engine configurations.
+*
+* Every opening is played twice with colours reversed, games run on worker
+* threads, and an optional sequential probability ratio test stops the match as
+* soon as the result is clear: H0 "A is elo0 stronger than B" against
+* H1 "A is elo1 stronger", with error rates alpha and beta. The log-likelihood
+* ratio uses the normal approximation of the game score, as fishtest did.
+*
+* Each game builds its own Oracles, since the structural oracle's pawn hash
+* table is not thread-safe. Networks, books and tablebases are read-only and
+* shared by every game.
+*/
+
+namespace match {
+
+// One side of the match, e.g. "new:eval=structural,depth=3".
+struct EngineConfig {
+    std::string name;
+    std::string evaluation = "material";  // material, structural or nnue
+    std::string eval_file;                // network for nnue
+    int depth = 2;                        // with a time control, the cap on iterative deepening (0: none)
+    std::string book_file;
+    std::string tablebase_path;
+};
+
+// "name:key=value,..." with keys eval, nnue, depth, book and tb
+inline EngineConfig parse_engine(const std::string& spec) {
+    EngineConfig config;
+    const size_t colon = spec.find(':');
+    config.name = spec.substr(0, colon);
+    if (config.name.empty()) throw std::runtime_error("match: engine needs a name: " + spec);
+    if (colon == std::string::npos) return config;
+    std::istringstream fields(spec.substr(colon + 1));
+    std::string field;
+    while (std::getline(fields, field, ',')) {
+        const size_t eq = field.find('=');
+        if (eq == std::string::npos) throw std::runtime_error("match: expected key=value in " + spec);
+        const std::string key = field.substr(0, eq);
+        const std::string value = field.substr(eq + 1);
+        if (key == "eval") {
+            config.evaluation = value;
+        } else if (key == "nnue") {
+            config.evaluation = "nnue";
+            config.eval_file = value;
+        } else if (key == "depth") {
+            config.depth = std::max(0, std::stoi(value));
+        } else if (key == "book") {
+            config.book_file = value;
+        } else if (key == "tb") {
+            config.tablebase_path = value;
+        } else {
+            throw std::runtime_error("match: unknown engine option " + key);
+        }
+    }
+    if (config.evaluation != "material" && config.evaluation != "structural" && config.evaluation != "nnue") {
+        throw std::runtime_error("match: unknown evaluation " + config.evaluation);
+    }
+    if (config.evaluation == "nnue" && config.eval_file.empty()) throw std::runtime_error("match: nnue needs nnue=<file>");
+    return config;
+}
+
+// Per-side clock: base time, plus an increment after every move. Disabled when base is 0.
+struct TimeControl {
+    int64_t base_ms = 0;
+    int64_t increment_ms = 0;
+    bool enabled() const { return base_ms > 0; }
+};
+
+// "seconds[+increment]", e.g. "10+0.1"
+inline TimeControl parse_time_control(const std::string& text) {
+    const size_t plus = text.find('+');
+    TimeControl tc;
+    tc.base_ms = static_cast<int64_t>(std::stod(text.substr(0, plus)) * 1000);
+    if (plus != std::string::npos) tc.increment_ms = static_cast<int64_t>(std::stod(text.substr(plus + 1)) * 1000);
+    if (tc.base_ms <= 0 || tc.increment_ms < 0) throw std::runtime_error("match: bad time control " + text);
+    return tc;
+}
+
+// Results from A's point of view
+struct Score {
+    uint64_t wins = 0;
+    uint64_t draws = 0;
+    uint64_t losses = 0;
+    uint64_t games() const { return wins + draws + losses; }
+};
+
+inline double expected_score(double elo) { return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0)); }
+
+// Mean score per game and the variance of that mean
+inline std::pair<double, double> score_statistics(const Score& score) {
+    const double n = static_cast<double>(score.games());
+    if (n == 0) return {0.5, 0.0};
+    const double w = score.wins / n;
+    const double d = score.draws / n;
+    const double mean = w + d / 2;
+    const double variance = w + d / 4 - mean * mean;
+    return {mean, variance / n};
+}
+
+// Log-likelihood ratio of H1 (elo1) against H0 (elo0)
+inline double sprt_llr(const Score& score, double elo0, double elo1) {
+    const auto [mean, variance] = score_statistics(score);
+    if (variance <= 0) return 0.0;
+    const double s0 = expected_score(elo0);
+    const double s1 = expected_score(elo1);
+    return (s1 - s0) * (2 * mean - s0 - s1) / (2 * variance);
+}
+
+// Elo difference estimate and its 95% margin
+inline std::pair<double, double> elo_estimate(const Score& score) {
+    const auto [mean, variance] = score_statistics(score);
+    const double s = std::clamp(mean, 1e-3, 1 - 1e-3);
+    const double elo = -400.0 * std::log10(1.0 / s - 1.0);
+    const double margin = 1.96 * std::sqrt(variance) * 400.0 / std::log(10.0) / (s * (1 - s));
+    return {elo, margin};
+}
+
+struct SprtOptions {
+    bool enabled = false;
+    double elo0 = 0.0;
+    double elo1 = 5.0;
+    double alpha = 0.05;
+    double beta = 0.05;
+    double lower_bound() const { return std::log(beta / (1 - alpha)); }
+    double upper_bound() const { return std::log((1 - beta) / alpha); }
+};
+
+struct MatchOptions {
+    int games = 100;
+    int threads = 1;
+    int max_plies = 400;  // longer games are adjudicated drawn
+    TimeControl time_control;
+    SprtOptions sprt;
+    std::vector<std::string> openings;  // FENs; the standard start position when empty
+    std::string pgn_path;               // every game is appended here if set
+};
+
+enum class Verdict { None, H0, H1 };
+
+struct MatchResult {
+    Score score;
+    double llr = 0.0;
+    Verdict verdict = Verdict::None;
+};
+
+// Opening positions: FEN or EPD lines (# comments), or the final positions of the games of a .pgn file.
+inline std::vector<std::string> load_openings(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("match: cannot open " + path);
+    std::vector<std::string> openings;
+    if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".pgn") == 0) {
+        pgn::Reader reader(in);
+        pgn::GameRecord record;
+        Game game;
+        while (reader.next(record)) {
+            pgn::replay(record, game);
+            openings.push_back(game.fen());
+        }
+    } else {
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::vector<std::string> words;
+            std::string word;
+            while (words.size() < 6 && fields >> word && word.find(';') == std::string::npos) words.push_back(word);
+            if (words.empty() || words[0][0] == '#') continue;
+            if (words.size() < 4) throw std::runtime_error("match: bad opening line " + line);
+            // EPD lines end after the en-passant square
+            if (words.size() < 6 || words[4].find_first_not_of("0123456789") != std::string::npos) {
+                words.resize(4);
+                words.push_back("0");
+                words.push_back("1");
+            }
+            std::string fen = words[0];
+            for (size_t i = 1; i < words.size(); ++i) fen += " " + words[i];
+            openings.push_back(fen);
+        }
+    }
+    if (openings.empty()) throw std::runtime_error("match: no openings in " + path);
+    return openings;
+}
+
+namespace match_detail {
+
+// An EngineConfig with its files loaded
+class Player {
+public:
+    explicit Player(EngineConfig config) : config_(std::move(config)) {
+        if (config_.evaluation == "nnue") network_ = nnue::Network::load(config_.eval_file);
+        if (!config_.book_file.empty()) book_ = book::OpeningBook::open(config_.book_file);
+        if (!config_.tablebase_path.empty()) tablebase_ = tablebase::Tablebase::open(config_.tablebase_path);
+    }
+
+    const EngineConfig& config() const { return config_; }
+
+    std::unique_ptr<DFS> agent(bool white, bool timed) const {
+        Oracle oracle = config_.evaluation == "structural" ? make_structural_oracle()
+                        : config_.evaluation == "nnue"     ? make_nnue_oracle(network_)
+                                                           : make_material_oracle();
+        auto dfs = std::make_unique<DFS>(std::move(oracle), white);
+        const int depth = config_.depth > 0 ? config_.depth : uci::MAX_SEARCH_DEPTH;
+        if (!timed && config_.depth == 0) throw std::runtime_error("match: depth=0 needs a time control");
+        dfs->set_max_depth(depth);
+        if (book_) dfs->set_book(book_);
+        if (tablebase_) dfs->set_tablebase(tablebase_);
+        return dfs;
+    }
+
+private:
+    EngineConfig config_;
+    std::shared_ptr<const nnue::Network> network_;
+    std::shared_ptr<const book::OpeningBook> book_;
+    std::shared_ptr<const tablebase::Tablebase> tablebase_;
+};
+
+// The move of a timed search: deepen until the budget is spent, then take the deepest finished iteration.
+inline Move timed_move(DFS& agent, const Game& game, int64_t budget_ms) {
+    const auto start = std::chrono::steady_clock::now();
+    BackgroundSearch search(agent, game.board(), game.get_halfmove_clock());
+    while (!search.done()) {
+        if (std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(budget_ms)) search.cancel();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    try {
+        return search.take();
+    } catch (const std::runtime_error&) {
+        return Lawyer::instance().legal_moves(game.board()).front();  // stopped before depth 1 finished
+    }
+}
+
+// Play one game; returns White's score and fills `record`.
+inline double play_game(const Player& white, const Player& black, const std::string& opening,
+                        const MatchOptions& options, pgn::GameRecord& record) {
+    const TimeControl& tc = options.time_control;
+    Game game;
+    game.load_fen(opening);
+    std::unique_ptr<DFS> agents[2] = {black.agent(false, tc.enabled()), white.agent(true, tc.enabled())};
+    int64_t clock_ms[2] = {tc.base_ms, tc.base_ms};  // [0] black, [1] white
+    std::string termination;
+    double white_score = 0.5;
+    int plies = 0;
+    while (game.status() == GameStatus::Ongoing) {
+        if (plies++ >= options.max_plies) {
+            termination = "adjudication";
+            break;
+        }
+        const int side = game.board().is_white_to_move() ? 1 : 0;
+        if (!tc.enabled()) {
+            const Move move = agents[side]->explore(game.board(), game.get_halfmove_clock());
+            if (game.verify_and_move(move) != 0) throw std::runtime_error("match: engine played an illegal move");
+            continue;
+        }
+        uci::Limits limits;
+        limits.wtime = clock_ms[1];
+        limits.btime = clock_ms[0];
+        limits.winc = limits.binc = tc.increment_ms;
+        const auto start = std::chrono::steady_clock::now();
+        const Move move = timed_move(*agents[side], game, uci::time_budget(limits, side == 1));
+        clock_ms[side] -= std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        if (clock_ms[side] < 0) {
+            termination = "time forfeit";
+            white_score = side == 1 ? 0.0 : 1.0;
+            break;
+        }
+        clock_ms[side] += tc.increment_ms;
+        if (game.verify_and_move(move) != 0) throw std::runtime_error("match: engine played an illegal move");
+    }
+    if (termination.empty()) {
+        if (game.winner() == GameWinner::White) white_score = 1.0;
+        else if (game.winner() == GameWinner::Black) white_score = 0.0;
+    }
+
+    record = pgn::record_of(game, {{"Event", "match"}, {"White", white.config().name}, {"Black", black.config().name}});
+    record.result = white_score == 1.0 ? "1-0" : white_score == 0.0 ? "0-1" : "1/2-1/2";
+    record.set_tag("Result", record.result);
+    if (!termination.empty()) record.set_tag("Termination", termination);
+    return white_score;
+}
+
+} // namespace match_detail
+
+/*
+* Play `a` against `b`. Game i plays opening i / 2, with A as White when i is even.
+* `progress` (if set) is called after every game under the result lock.
+*/
+inline MatchResult run(const EngineConfig& a, const EngineConfig& b, const MatchOptions& options,
+                       const std::function<void(const MatchResult&)>& progress = {}) {
+    const match_detail::Player player_a(a);
+    const match_detail::Player player_b(b);
+    const std::vector<std::string> openings =
+        options.openings.empty() ? std::vector<std::string>{fen::STARTING_POSITION} : options.openings;
+    std::ofstream pgn_out;
+    if (!options.pgn_path.empty()) {
+        pgn_out.open(options.pgn_path, std::ios::app);
+        if (!pgn_out) throw std::runtime_error("match: cannot write " + options.pgn_path);
+    }
+
+    MatchResult result;
+    std::mutex result_mutex;
+    std::atomic<int> next_game{0};
+    std::atomic<bool> finished{false};
+    std::string error;
+    auto worker = [&] {
+        pgn::GameRecord record;
+        while (!finished.load()) {
+            const int index = next_game.fetch_add(1);
+            if (index >= options.games) break;
+            const bool a_white = index % 2 == 0;
+            const std::string& opening = openings[(index / 2) % openings.size()];
+            double a_score;
+            try {
+                const double white_score = a_white ? match_detail::play_game(player_a, player_b, opening, options, record)
+                                                   : match_detail::play_game(player_b, player_a, opening, options, record);
+                a_score = a_white ? white_score : 1.0 - white_score;
+            } catch (const std::exception& ex) {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                error = ex.what();
+                finished.store(true);
+                break;
+            }
+            record.set_tag("Round", std::to_string(index + 1));
+
+            std::lock_guard<std::mutex> lock(result_mutex);
+            if (finished.load()) break;  // decided while this game was being played
+            if (a_score == 1.0) ++result.score.wins;
+            else if (a_score == 0.0) ++result.score.losses;
+            else ++result.score.draws;
+            if (pgn_out.is_open()) pgn::write(record, pgn_out);
+            if (options.sprt.enabled) {
+                result.llr = sprt_llr(result.score, options.sprt.elo0, options.sprt.elo1);
+                if (result.llr <= options.sprt.lower_bound()) result.verdict = Verdict::H0;
+                if (result.llr >= options.sprt.upper_bound()) result.verdict = Verdict::H1;
+                if (result.verdict != Verdict::None) finished.store(true);
+            }
+            if (progress) progress(result);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int t = 0; t < std::max(1, options.threads); ++t) workers.emplace_back(worker);
+    for (auto& thread : workers) thread.join();
+    if (!error.empty()) throw std::runtime_error(error);
+    return result;
+}
+
+} // namespace match
+
+#endif // MATCH_H
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "match.h"
+
+/*
+* match_runner
+* Plays two engine configurations against each other, e.g.
+*
+*   match_runner --engine base:eval=material,depth=2 --engine new:eval=structural,depth=2 \
+*                --openings openings.epd --games 2000 -j 8 --tc 10+0.1 --sprt 0 5 --pgn games.pgn
+*
+* Engine options: eval=material|structural, nnue=<network>, depth=<plies> (a cap
+* with --tc, 0 for none), book=<file>, tb=<directory>.
+*/
+
+static void usage(void) {
+    std::cerr << "usage: match_runner --engine <name:options> --engine <name:options> [--games <n>] [-j <threads>]\n"
+                 "                    [--openings <file>] [--tc <seconds+increment>] [--max-plies <n>]\n"
+                 "                    [--sprt <elo0> <elo1>] [--alpha <a>] [--beta <b>] [--pgn <file>]\n";
+}
+
+static std::string verdict_text(match::Verdict verdict) {
+    switch (verdict) {
+        case match::Verdict::H0: return "H0 accepted";
+        case match::Verdict::H1: return "H1 accepted";
+        default: return "no verdict";
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<match::EngineConfig> engines;
+    match::MatchOptions options;
+    options.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool has_value = i + 1 < argc;
+            if (arg == "--engine" && has_value) {
+                engines.push_back(match::parse_engine(argv[++i]));
+            } else if (arg == "--games" && has_value) {
+                options.games = std::max(1, std::stoi(argv[++i]));
+            } else if ((arg == "-j" || arg == "--threads") && has_value) {
+                options.threads = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--openings" && has_value) {
+                options.openings = match::load_openings(argv[++i]);
+            } else if (arg == "--tc" && has_value) {
+                options.time_control = match::parse_time_control(argv[++i]);
+            } else if (arg == "--max-plies" && has_value) {
+                options.max_plies = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--sprt" && i + 2 < argc) {
+                options.sprt.enabled = true;
+                options.sprt.elo0 = std::stod(argv[++i]);
+                options.sprt.elo1 = std::stod(argv[++i]);
+            } else if (arg == "--alpha" && has_value) {
+                options.sprt.alpha = std::stod(argv[++i]);
+            } else if (arg == "--beta" && has_value) {
+                options.sprt.beta = std::stod(argv[++i]);
+            } else if (arg == "--pgn" && has_value) {
+                options.pgn_path = argv[++i];
+            } else {
+                usage();
+                return 1;
+            }
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << "\n";
+        usage();
+        return 1;
+    }
+    if (engines.size() != 2) {
+        usage();
+        return 1;
+    }
+
+    try {
+        auto print = [&](const match::MatchResult& result) {
+            const auto [elo, margin] = match::elo_estimate(result.score);
+            std::printf("%s vs %s: +%llu =%llu -%llu  elo %+.1f +/- %.1f",
+                        engines[0].name.c_str(), engines[1].name.c_str(),
+                        static_cast<unsigned long long>(result.score.wins),
+                        static_cast<unsigned long long>(result.score.draws),
+                        static_cast<unsigned long long>(result.score.losses), elo, margin);
+            if (options.sprt.enabled) {
+                std::printf("  llr %.2f (%.2f, %.2f)", result.llr, options.sprt.lower_bound(), options.sprt.upper_bound());
+            }
+            std::printf("\n");
+            std::fflush(stdout);
+        };
+        const match::MatchResult result = match::run(engines[0], engines[1], options, print);
+        if (options.sprt.enabled) std::cout << "SPRT: " << verdict_text(result.verdict) << "\n";
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,310 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "piece.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+* NNUE: small efficiently-updatable neural network evaluation.
+*
+* Architecture: (768 -> HIDDEN) x 2 -> L1 -> L2 -> 1
+* - The first layer ("feature transformer") is a sparse, piece-square input:
+*   one feature per (colour relative to perspective, piece kind, square).
+*   Its output, the accumulator, is kept per perspective (white and black) and
+*   updated incrementally when a move adds or removes pieces, so its cost is
+*   a handful of row additions per move instead of a full matrix product.
+* - The remaining layers are tiny dense int8 layers evaluated on the clipped
+*   accumulator of the side to move (first half) and the other side (second half).
+*
+* This header knows nothing about Board: the Board owns the accumulator and the
+* Lawyer describes each move as a FeatureDelta. See Board::attach_accumulator().
+*
+* Kernels use AVX2 or SSSE3 (SSE2 for the accumulator) when the compiler targets
+* them, and fall back to plain loops otherwise.
+*/
+
+namespace nnue {
+
+constexpr int INPUTS = 2 * 6 * 64;
+constexpr int HIDDEN = 128;          // accumulator width, per perspective
+constexpr int L1 = 32;
+constexpr int L2 = 32;
+
+constexpr int CLIP_MAX = 127;        // clipped ReLU ceiling (activations fit in u8)
+constexpr int WEIGHT_SHIFT = 6;      // dense layers use weights scaled by 2^6
+constexpr int OUTPUT_SCALE = 16;     // raw output / OUTPUT_SCALE = centipawns
+
+static constexpr char FILE_MAGIC[8] = {'J', 'C', 'O', 'N', 'N', 'U', 'E', '1'};
+
+struct Network {
+    alignas(32) int16_t ft_weights[INPUTS * HIDDEN];
+    alignas(32) int16_t ft_biases[HIDDEN];
+    alignas(32) int8_t l1_weights[L1 * 2 * HIDDEN];
+    alignas(32) int32_t l1_biases[L1];
+    alignas(32) int8_t l2_weights[L2 * L1];
+    alignas(32) int32_t l2_biases[L2];
+    alignas(32) int8_t out_weights[L2];
+    int32_t out_bias;
+
+    // Weights file layout (little-endian):
+    //   8-byte magic "JCONNUE1", then int32 INPUTS, HIDDEN, L1, L2,
+    //   then every array above in declaration order.
+    static std::shared_ptr<Network> load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("nnue::Network::load: cannot open " + path);
+        }
+        char magic[8];
+        in.read(magic, sizeof(magic));
+        if (!in || std::memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0) {
+            throw std::runtime_error("nnue::Network::load: bad magic in " + path);
+        }
+        int32_t dims[4];
+        in.read(reinterpret_cast<char*>(dims), sizeof(dims));
+        if (!in || dims[0] != INPUTS || dims[1] != HIDDEN || dims[2] != L1 || dims[3] != L2) {
+            throw std::runtime_error("nnue::Network::load: architecture mismatch in " + path);
+        }
+        auto net = std::make_shared<Network>();
+        auto read = [&](void* dst, size_t bytes) {
+            in.read(reinterpret_cast<char*>(dst), bytes);
+            if (!in) throw std::runtime_error("nnue::Network::load: truncated file " + path);
+        };
+        read(net->ft_weights, sizeof(net->ft_weights));
+        read(net->ft_biases, sizeof(net->ft_biases));
+        read(net->l1_weights, sizeof(net->l1_weights));
+        read(net->l1_biases, sizeof(net->l1_biases));
+        read(net->l2_weights, sizeof(net->l2_weights));
+        read(net->l2_biases, sizeof(net->l2_biases));
+        read(net->out_weights, sizeof(net->out_weights));
+        read(&net->out_bias, sizeof(net->out_bias));
+        return net;
+    }
+
+    void save(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("nnue::Network::save: cannot open " + path);
+        }
+        const int32_t dims[4] = {INPUTS, HIDDEN, L1, L2};
+        out.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+        out.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+        out.write(reinterpret_cast<const char*>(ft_weights), sizeof(ft_weights));
+        out.write(reinterpret_cast<const char*>(ft_biases), sizeof(ft_biases));
+        out.write(reinterpret_cast<const char*>(l1_weights), sizeof(l1_weights));
+        out.write(reinterpret_cast<const char*>(l1_biases), sizeof(l1_biases));
+        out.write(reinterpret_cast<const char*>(l2_weights), sizeof(l2_weights));
+        out.write(reinterpret_cast<const char*>(l2_biases), sizeof(l2_biases));
+        out.write(reinterpret_cast<const char*>(out_weights), sizeof(out_weights));
+        out.write(reinterpret_cast<const char*>(&out_bias), sizeof(out_bias));
+        if (!out) {
+            throw std::runtime_error("nnue::Network::save: write failed for " + path);
+        }
+    }
+};
+
+// First-layer output for both perspectives. [0] is white's, [1] is black's.
+struct Accumulator {
+    alignas(32) int16_t values[2][HIDDEN];
+    const Network* network = nullptr;
+};
+
+// Index of the input feature for a piece, seen from one side.
+// Black's perspective mirrors the board vertically so both halves share weights.
+inline int feature_index(bool perspective_white, PieceKind kind, bool piece_white, int x, int y) {
+    int square = y * 8 + x;
+    if (!perspective_white) square ^= 56;
+    const int relative_colour = (piece_white == perspective_white) ? 0 : 1;
+    return (relative_colour * 6 + static_cast<int>(kind)) * 64 + square;
+}
+
+/*
+* The pieces a move removed and added, e.g. a capture-promotion removes the pawn
+* and the captured piece and adds the promoted piece. At most 2 of each.
+*/
+struct FeatureDelta {
+    struct Entry { PieceKind kind; bool white; int x, y; };
+    Entry removed[2];
+    Entry added[2];
+    int removed_count = 0;
+    int added_count = 0;
+
+    void remove(PieceKind kind, bool white, int x, int y) { removed[removed_count++] = Entry{kind, white, x, y}; }
+    void add(PieceKind kind, bool white, int x, int y) { added[added_count++] = Entry{kind, white, x, y}; }
+};
+
+namespace kernels {
+
+// acc += row
+inline void add_row(int16_t* acc, const int16_t* row) {
+#if defined(__AVX2__)
+    for (int i = 0; i < HIDDEN; i += 16) {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+        __m256i r = _mm256_load_si256(reinterpret_cast<const __m256i*>(row + i));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_add_epi16(a, r));
+    }
+#elif defined(__SSE2__)
+    for (int i = 0; i < HIDDEN; i += 8) {
+        __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i));
+        __m128i r = _mm_load_si128(reinterpret_cast<const __m128i*>(row + i));
+        _mm_store_si128(reinterpret_cast<__m128i*>(acc + i), _mm_add_epi16(a, r));
+    }
+#else
+    for (int i = 0; i < HIDDEN; ++i) acc[i] = static_cast<int16_t>(acc[i] + row[i]);
+#endif
+}
+
+// acc -= row
+inline void sub_row(int16_t* acc, const int16_t* row) {
+#if defined(__AVX2__)
+    for (int i = 0; i < HIDDEN; i += 16) {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+        __m256i r = _mm256_load_si256(reinterpret_cast<const __m256i*>(row + i));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_sub_epi16(a, r));
+    }
+#elif defined(__SSE2__)
+    for (int i = 0; i < HIDDEN; i += 8) {
+        __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i));
+        __m128i r = _mm_load_si128(reinterpret_cast<const __m128i*>(row + i));
+        _mm_store_si128(reinterpret_cast<__m128i*>(acc + i), _mm_sub_epi16(a, r));
+    }
+#else
+    for (int i = 0; i < HIDDEN; ++i) acc[i] = static_cast<int16_t>(acc[i] - row[i]);
+#endif
+}
+
+// out[i] = clamp(in[i], 0, CLIP_MAX) as u8
+inline void clip_accumulator(const int16_t* in, uint8_t* out) {
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    for (int i = 0; i < HIDDEN; i += 32) {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(in + i + 16));
+        // Signed pack saturates to [-128, 127]; max with zero then clips to [0, 127].
+        __m256i packed = _mm256_packs_epi16(a, b);
+        packed = _mm256_max_epi8(packed, zero);
+        packed = _mm256_permute4x64_epi64(packed, 0xD8);  // undo the per-lane interleave
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+#else
+    for (int i = 0; i < HIDDEN; ++i) {
+        const int v = in[i];
+        out[i] = static_cast<uint8_t>(v < 0 ? 0 : (v > CLIP_MAX ? CLIP_MAX : v));
+    }
+#endif
+}
+
+// Dot product of `n` u8 activations (<= 127) with int8 weights. n is a multiple of 32.
+inline int32_t dot_u8_i8(const uint8_t* x, const int8_t* w, int n) {
+#if defined(__AVX2__)
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < n; i += 32) {
+        __m256i xv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+        __m256i wv = _mm256_load_si256(reinterpret_cast<const __m256i*>(w + i));
+        // Activations are <= 127 so pairwise sums fit in int16 without saturating.
+        __m256i prod = _mm256_maddubs_epi16(xv, wv);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(prod, ones));
+    }
+    __m128i lo = _mm256_castsi256_si128(sum);
+    __m128i hi = _mm256_extracti128_si256(sum, 1);
+    __m128i s = _mm_add_epi32(lo, hi);
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+#elif defined(__SSSE3__)
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < n; i += 16) {
+        __m128i xv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+        __m128i wv = _mm_load_si128(reinterpret_cast<const __m128i*>(w + i));
+        __m128i prod = _mm_maddubs_epi16(xv, wv);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(prod, ones));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+#else
+    int32_t sum = 0;
+    for (int i = 0; i < n; ++i) sum += static_cast<int32_t>(x[i]) * static_cast<int32_t>(w[i]);
+    return sum;
+#endif
+}
+
+// Dense layer with clipped ReLU: out = clamp((W x + b) >> WEIGHT_SHIFT, 0, CLIP_MAX)
+inline void affine_clipped_relu(const uint8_t* in, int in_dim,
+                                const int8_t* weights, const int32_t* biases,
+                                int out_dim, uint8_t* out) {
+    for (int o = 0; o < out_dim; ++o) {
+        int32_t v = (biases[o] + dot_u8_i8(in, weights + o * in_dim, in_dim)) >> WEIGHT_SHIFT;
+        out[o] = static_cast<uint8_t>(v < 0 ? 0 : (v > CLIP_MAX ? CLIP_MAX : v));
+    }
+}
+
+} // namespace kernels
+
+// Recompute both perspectives from scratch. `for_each_piece` calls its argument
+// with (kind, white, x, y) for every piece on the board.
+template <typename ForEachPiece>
+inline void refresh(Accumulator& acc, const Network& net, ForEachPiece&& for_each_piece) {
+    acc.network = &net;
+    std::memcpy(acc.values[0], net.ft_biases, sizeof(net.ft_biases));
+    std::memcpy(acc.values[1], net.ft_biases, sizeof(net.ft_biases));
+    for_each_piece([&](PieceKind kind, bool white, int x, int y) {
+        kernels::add_row(acc.values[0], net.ft_weights + feature_index(true, kind, white, x, y) * HIDDEN);
+        kernels::add_row(acc.values[1], net.ft_weights + feature_index(false, kind, white, x, y) * HIDDEN);
+    });
+}
+
+// Apply a move's feature changes to both perspectives.
+inline void apply_delta(Accumulator& acc, const FeatureDelta& delta) {
+    if (acc.network == nullptr) {
+        throw std::runtime_error("nnue::apply_delta: accumulator has no network");
+    }
+    const Network& net = *acc.network;
+    for (int p = 0; p < 2; ++p) {
+        const bool perspective_white = (p == 0);
+        for (int i = 0; i < delta.removed_count; ++i) {
+            const FeatureDelta::Entry& e = delta.removed[i];
+            kernels::sub_row(acc.values[p], net.ft_weights + feature_index(perspective_white, e.kind, e.white, e.x, e.y) * HIDDEN);
+        }
+        for (int i = 0; i < delta.added_count; ++i) {
+            const FeatureDelta::Entry& e = delta.added[i];
+            kernels::add_row(acc.values[p], net.ft_weights + feature_index(perspective_white, e.kind, e.white, e.x, e.y) * HIDDEN);
+        }
+    }
+}
+
+// Run the dense layers. Returns centipawns from the side to move's point of view.
+inline int evaluate(const Accumulator& acc, bool white_to_move) {
+    if (acc.network == nullptr) {
+        throw std::runtime_error("nnue::evaluate: accumulator has no network");
+    }
+    const Network& net = *acc.network;
+    alignas(32) uint8_t input[2 * HIDDEN];
+    alignas(32) uint8_t hidden1[L1];
+    alignas(32) uint8_t hidden2[L2];
+    const int us = white_to_move ? 0 : 1;
+    kernels::clip_accumulator(acc.values[us], input);
+    kernels::clip_accumulator(acc.values[1 - us], input + HIDDEN);
+    kernels::affine_clipped_relu(input, 2 * HIDDEN, net.l1_weights, net.l1_biases, L1, hidden1);
+    kernels::affine_clipped_relu(hidden1, L1, net.l2_weights, net.l2_biases, L2, hidden2);
+    const int32_t output = net.out_bias + kernels::dot_u8_i8(hidden2, net.out_weights, L2);
+    return output / OUTPUT_SCALE;
+}
+
+} // namespace nnue
+
+#endif // NNUE_H
@@ -0,0 +1,210 @@
+#ifndef OPENING_BOOK_H
+#define OPENING_BOOK_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "board.h"
+#include "lawyer.h"
+#include "move.h"
+
+/*
+* Opening book: for each known position, the moves played from it and how good they are.
+*
+* File layout (little-endian):
+*   8-byte magic "JCOBOOK1", uint64 entry count,
+*   then the entries, 16 bytes each, sorted by (key, move).
+* `key` is Board::get_hash(), so transpositions share entries.
+*
+* The file is mmap'ed read-only and searched in place with a binary search: opening
+* a book costs nothing however large it is, and a probe touches a handful of pages.
+*/
+
+namespace book {
+
+inline constexpr char FILE_MAGIC[8] = {'J', 'C', 'O', 'B', 'O', 'O', 'K', '1'};
+
+struct Entry {
+    uint64_t key;     // Zobrist hash of the position
+    uint16_t move;    // see encode_move()
+    uint16_t weight;  // relative preference among the moves of this position
+    uint32_t games;   // games the move was played in
+};
+static_assert(sizeof(Entry) == 16, "book::Entry is part of the file format");
+
+inline bool operator<(const Entry& lhs, const Entry& rhs) {
+    return lhs.key != rhs.key ? lhs.key < rhs.key : lhs.move < rhs.move;
+}
+
+// from square (6 bits) | to square (6 bits) << 6 | (promotion kind + 1) (3 bits) << 12
+inline uint16_t encode_move(const Move& move) {
+    uint16_t code = static_cast<uint16_t>((move.from_y() * 8 + move.from_x()) | ((move.to_y() * 8 + move.to_x()) << 6));
+    if (move.has_promotion()) code |= static_cast<uint16_t>((static_cast<int>(move.get_promotion()) + 1) << 12);
+    return code;
+}
+
+// The move `code` stands for in `board`, if it is legal there (it may not be after a hash collision).
+inline std::optional<Move> decode_move(uint16_t code, const Board& board) {
+    const int from = code & 63;
+    const int to = (code >> 6) & 63;
+    const int promotion = (code >> 12) & 7;
+    Move move(from % 8, from / 8, to % 8, to / 8, board);
+    if (!move.is_valid()) return std::nullopt;
+    if (move.is_attempted_promotion() != (promotion != 0)) return std::nullopt;
+    if (promotion != 0) {
+        const int kind = promotion - 1;
+        if (kind == static_cast<int>(PieceKind::King) || kind > static_cast<int>(PieceKind::Knight)) return std::nullopt;
+        move.set_promotion(static_cast<PieceKind>(kind));
+    }
+    if (!Lawyer::instance().legal(board, move)) return std::nullopt;
+    return move;
+}
+
+// Writes a book file from entries appended in sorted order, e.g. straight out of a merge.
+class Writer {
+public:
+    explicit Writer(const std::string& path) : path_(path), out_(path, std::ios::binary | std::ios::trunc) {
+        if (!out_) {
+            throw std::runtime_error("book::Writer: cannot open " + path);
+        }
+        const uint64_t count = 0;  // patched by finish()
+        out_.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+        out_.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    }
+
+    void append(const Entry& entry) {
+        if (count_ > 0 && entry < last_) {
+            throw std::runtime_error("book::Writer: entries out of order in " + path_);
+        }
+        out_.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        last_ = entry;
+        ++count_;
+    }
+
+    // Fill in the entry count and close the file. Returns the number of entries.
+    uint64_t finish(void) {
+        out_.seekp(sizeof(FILE_MAGIC));
+        out_.write(reinterpret_cast<const char*>(&count_), sizeof(count_));
+        out_.close();
+        if (!out_) {
+            throw std::runtime_error("book::Writer: write failed for " + path_);
+        }
+        return count_;
+    }
+
+private:
+    std::string path_;
+    std::ofstream out_;
+    Entry last_{};
+    uint64_t count_ = 0;
+};
+
+// Sort `entries` and write them as a book file.
+inline void write(const std::string& path, std::vector<Entry>& entries) {
+    std::sort(entries.begin(), entries.end());
+    Writer writer(path);
+    for (const Entry& entry : entries) writer.append(entry);
+    writer.finish();
+}
+
+class OpeningBook {
+public:
+    static std::shared_ptr<const OpeningBook> open(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw std::runtime_error("book::OpeningBook::open: cannot open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(HEADER_SIZE)) {
+            ::close(fd);
+            throw std::runtime_error("book::OpeningBook::open: truncated file " + path);
+        }
+        const size_t size = static_cast<size_t>(st.st_size);
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);  // the mapping keeps the file alive
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("book::OpeningBook::open: mmap failed for " + path);
+        }
+        std::shared_ptr<OpeningBook> opened(new OpeningBook(mapped, size));
+        const char* bytes = static_cast<const char*>(mapped);
+        uint64_t count = 0;
+        std::memcpy(&count, bytes + sizeof(FILE_MAGIC), sizeof(count));
+        if (std::memcmp(bytes, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+            throw std::runtime_error("book::OpeningBook::open: bad magic in " + path);
+        }
+        if (count != (size - HEADER_SIZE) / sizeof(Entry) || (size - HEADER_SIZE) % sizeof(Entry) != 0) {
+            throw std::runtime_error("book::OpeningBook::open: size mismatch in " + path);
+        }
+        opened->entries_ = reinterpret_cast<const Entry*>(bytes + HEADER_SIZE);
+        opened->count_ = static_cast<size_t>(count);
+        // Probes jump around the file
+        ::madvise(mapped, size, MADV_RANDOM);
+        return opened;
+    }
+
+    ~OpeningBook() { ::munmap(mapped_, size_); }
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    size_t size(void) const { return count_; }
+
+    // All entries for position `key`, as [first, last).
+    std::pair<const Entry*, const Entry*> find(uint64_t key) const {
+        const Entry* begin = entries_;
+        const Entry* end = entries_ + count_;
+        const Entry* first = std::lower_bound(begin, end, key, [](const Entry& e, uint64_t k) { return e.key < k; });
+        const Entry* last = first;
+        while (last != end && last->key == key) ++last;
+        return {first, last};
+    }
+
+    /*
+    * A book move for `board`, or nullopt if the position is not in the book.
+    * `random` picks among the moves in proportion to their weights (any value from a
+    * uniform 64-bit generator); moves that are not legal in `board` are ignored.
+    */
+    std::optional<Move> probe(const Board& board, uint64_t random) const {
+        const auto [first, last] = find(board.get_hash());
+        uint64_t total = 0;
+        for (const Entry* e = first; e != last; ++e) total += e->weight;
+        if (total == 0) return std::nullopt;
+
+        uint64_t pick = random % total;
+        const Entry* chosen = first;
+        for (; chosen != last; ++chosen) {
+            if (pick < chosen->weight) break;
+            pick -= chosen->weight;
+        }
+        if (auto move = decode_move(chosen->move, board)) return move;
+        // Collision or corrupt entry: fall back to any legal book move
+        for (const Entry* e = first; e != last; ++e) {
+            if (e->weight == 0) continue;
+            if (auto move = decode_move(e->move, board)) return move;
+        }
+        return std::nullopt;
+    }
+
+private:
+    static constexpr size_t HEADER_SIZE = sizeof(FILE_MAGIC) + sizeof(uint64_t);
+
+    OpeningBook(void* mapped, size_t size) : mapped_(mapped), size_(size) {}
+
+    void* mapped_;
+    size_t size_;
+    const Entry* entries_ = nullptr;
+    size_t count_ = 0;
+};
+
+} // namespace book
+
+#endif // OPENING_BOOK_H
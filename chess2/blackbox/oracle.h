@@ -1,9 +1,13 @@
 #ifndef ORACLE_H
 #define ORACLE_H
 
+#include <cstddef>
 #include <functional>
+#include <memory>
 #include "board.h"
 #include "material.h"
+#include "nnue.h"
+#include "pawn_structure.h"
 
 /*
 * class Oracle
@@ -11,23 +15,53 @@
 * A score of 0 should be for draws or very even positions.
 * A score of +infty means White wins, and -infty means Black wins.
 * This is consistent with most "score" notations from other engines.
+*
+* An Oracle may also provide a Preparer, which the search calls once on its own
+* copy of the root board before exploring (e.g. to attach an NNUE accumulator
+* that then gets copied and incrementally updated down the tree).
+*
+* evaluate_batch() scores many leaves in one call, so evaluators can amortize
+* per-call overhead and prefetch what the next positions need. Oracles without
+* a BatchEvaluator just loop over evaluate().
 */
 
 class Oracle {
 public:
     using Evaluator = std::function<double(const Board&)>;
+    using Preparer = std::function<void(Board&)>;
+    using BatchEvaluator = std::function<void(const Board* const* boards, double* scores, size_t count)>;
 
     Oracle()
         : evaluator_([](const Board&) { return 0.0; }) {}
     explicit Oracle(Evaluator evaluator)
         : evaluator_(std::move(evaluator)) {}
+    Oracle(Evaluator evaluator, Preparer preparer)
+        : evaluator_(std::move(evaluator)), preparer_(std::move(preparer)) {}
+    Oracle(Evaluator evaluator, Preparer preparer, BatchEvaluator batch_evaluator)
+        : evaluator_(std::move(evaluator)), preparer_(std::move(preparer)),
+          batch_evaluator_(std::move(batch_evaluator)) {}
 
     double evaluate(const Board& board) const {
         return evaluator_(board);
     }
 
+    // scores[i] = evaluate(*boards[i]) for i in [0, count)
+    void evaluate_batch(const Board* const* boards, double* scores, size_t count) const {
+        if (batch_evaluator_) {
+            batch_evaluator_(boards, scores, count);
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) scores[i] = evaluator_(*boards[i]);
+    }
+
+    void prepare(Board& root) const {
+        if (preparer_) preparer_(root);
+    }
+
 private:
     Evaluator evaluator_;
+    Preparer preparer_;
+    BatchEvaluator batch_evaluator_;
 };
 
 inline Oracle make_material_oracle() {
@@ -36,4 +70,54 @@ inline Oracle make_material_oracle() {
     });
 }
 
+// Material plus pawn structure, with the pawn part cached in a pawn hash table
+// shared by every copy of the returned Oracle.
+inline Oracle make_structural_oracle(int pawn_hash_size_log2 = 14) {
+    auto table = std::make_shared<pawn_structure::PawnHashTable>(pawn_hash_size_log2);
+    auto evaluate = [table](const Board& board) {
+        return material::balance(board) + pawn_structure::score(board, *table) / 100.0;
+    };
+    return Oracle(
+        evaluate,
+        Oracle::Preparer{},
+        [table, evaluate](const Board* const* boards, double* scores, size_t count) {
+            // Start pulling in every table slot before touching the first one
+            for (size_t i = 0; i < count; ++i) table->prefetch(boards[i]->get_pawn_key());
+            for (size_t i = 0; i < count; ++i) scores[i] = evaluate(*boards[i]);
+        });
+}
+
+// Scores are in pawns, like the material oracle.
+// Boards without an up-to-date accumulator for this network are evaluated from scratch.
+inline Oracle make_nnue_oracle(std::shared_ptr<const nnue::Network> network) {
+    auto evaluate = [network](const Board& board) {
+        const bool white_to_move = board.is_white_to_move();
+        int centipawns;
+        if (board.has_accumulator() && board.get_accumulator().network == network.get()) {
+            centipawns = nnue::evaluate(board.get_accumulator(), white_to_move);
+        } else {
+            Board scratch(board);
+            scratch.attach_accumulator(*network);
+            centipawns = nnue::evaluate(scratch.get_accumulator(), white_to_move);
+        }
+        if (!white_to_move) centipawns = -centipawns;
+        return centipawns / 100.0;
+    };
+    return Oracle(
+        evaluate,
+        [network](Board& root) {
+            root.attach_accumulator(*network);
+        },
+        [evaluate](const Board* const* boards, double* scores, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                // Fetch the next accumulator while the dense layers run on this one
+                if (i + 1 < count && boards[i + 1]->has_accumulator()) {
+                    const char* next = reinterpret_cast<const char*>(&boards[i + 1]->get_accumulator());
+                    for (size_t off = 0; off < sizeof(nnue::Accumulator); off += 64) __builtin_prefetch(next + off);
+                }
+                scores[i] = evaluate(*boards[i]);
+            }
+        });
+}
+
 #endif // ORACLE_H
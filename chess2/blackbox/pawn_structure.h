@@ -0,0 +1,134 @@
+#ifndef PAWN_STRUCTURE_H
+#define PAWN_STRUCTURE_H
+
+#include <cstdint>
+#include <vector>
+#include "board.h"
+
+/*
+* Pawn structure evaluation: doubled, isolated and passed pawns.
+*
+* The pawn-only part of the evaluation depends on nothing but the pawns, which
+* rarely change between neighbouring search nodes. PawnHashTable caches it keyed
+* by Board::get_pawn_key(), so most leaves skip the pawn scan entirely.
+*
+* Scores are in centipawns from white's perspective, like the rest of the evaluation.
+*/
+
+namespace pawn_structure {
+
+constexpr int DOUBLED_PENALTY = 15;    // per extra pawn on a file
+constexpr int ISOLATED_PENALTY = 12;   // per pawn with no friendly pawns on adjacent files
+constexpr int FREE_PASSER_BONUS = 10;  // per passed pawn whose next square is empty
+// Passed pawn bonus by rank, from the pawn owner's side (rank 2 is index 1)
+constexpr int PASSED_BONUS[8] = {0, 5, 10, 20, 35, 60, 100, 0};
+
+inline uint64_t square_bit(int x, int y) { return uint64_t{1} << (y * 8 + x); }
+
+struct Entry {
+    uint64_t key = 0;
+    uint64_t passed[2] = {0, 0};  // passed pawns, [0] white, [1] black, bit y * 8 + x
+    int score = 0;                // pawn-only score, white's perspective
+    bool used = false;
+};
+
+// Scan the pawns and score their structure from scratch.
+inline Entry evaluate(const Board& board) {
+    uint64_t pawns[2] = {0, 0};
+    int file_count[2][8] = {{0}};
+    const int count = board.get_piece_count();
+    for (int i = 0; i < count; ++i) {
+        const Piece& p = board.get_piece(i);
+        if (p.kind != PieceKind::Pawn) continue;
+        const int side = p.white ? 0 : 1;
+        pawns[side] |= square_bit(p.x, p.y);
+        ++file_count[side][p.x];
+    }
+
+    Entry entry;
+    entry.key = board.get_pawn_key();
+    entry.used = true;
+    for (int side = 0; side < 2; ++side) {
+        const int sign = (side == 0) ? 1 : -1;
+        const int dir = (side == 0) ? 1 : -1;
+        int score = 0;
+        for (int x = 0; x < 8; ++x) {
+            if (file_count[side][x] > 1) score -= DOUBLED_PENALTY * (file_count[side][x] - 1);
+            const bool left = x > 0 && file_count[side][x - 1] > 0;
+            const bool right = x < 7 && file_count[side][x + 1] > 0;
+            if (!left && !right) score -= ISOLATED_PENALTY * file_count[side][x];
+        }
+        for (int sq = 0; sq < 64; ++sq) {
+            if (!(pawns[side] & (uint64_t{1} << sq))) continue;
+            const int x = sq % 8;
+            const int y = sq / 8;
+            bool passed = true;
+            for (int ty = y + dir; passed && ty >= 0 && ty < 8; ty += dir) {
+                for (int tx = x - 1; tx <= x + 1; ++tx) {
+                    if (tx < 0 || tx > 7) continue;
+                    if (pawns[1 - side] & square_bit(tx, ty)) { passed = false; break; }
+                }
+            }
+            if (!passed) continue;
+            entry.passed[side] |= square_bit(x, y);
+            score += PASSED_BONUS[side == 0 ? y : 7 - y];
+        }
+        entry.score += sign * score;
+    }
+    return entry;
+}
+
+/*
+* Direct-mapped cache of pawn structure entries, always replacing on collision.
+* Size is a power of two so the index is just the low bits of the key.
+*/
+class PawnHashTable {
+public:
+    explicit PawnHashTable(int size_log2 = 14)
+        : entries_(size_t{1} << size_log2), mask_((uint64_t{1} << size_log2) - 1) {}
+
+    const Entry& probe(const Board& board) {
+        const uint64_t key = board.get_pawn_key();
+        Entry& slot = entries_[key & mask_];
+        if (slot.used && slot.key == key) {
+            ++hits_;
+            return slot;
+        }
+        ++misses_;
+        slot = evaluate(board);
+        return slot;
+    }
+
+    // Hint the CPU to load the slot for `key` ahead of a probe
+    void prefetch(uint64_t key) const { __builtin_prefetch(&entries_[key & mask_]); }
+
+    uint64_t hits(void) const { return hits_; }
+    uint64_t misses(void) const { return misses_; }
+
+private:
+    std::vector<Entry> entries_;
+    uint64_t mask_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+// Cached pawn-only score plus the piece-dependent passed pawn terms.
+inline int score(const Board& board, PawnHashTable& table) {
+    const Entry& entry = table.probe(board);
+    int total = entry.score;
+    for (int side = 0; side < 2; ++side) {
+        const int dir = (side == 0) ? 1 : -1;
+        const int sign = (side == 0) ? 1 : -1;
+        for (int sq = 0; sq < 64; ++sq) {
+            if (!(entry.passed[side] & (uint64_t{1} << sq))) continue;
+            const int ty = sq / 8 + dir;
+            if (ty < 0 || ty > 7) continue;
+            if (board.find_piece_at(sq % 8, ty) == -1) total += sign * FREE_PASSER_BONUS;
+        }
+    }
+    return total;
+}
+
+} // namespace pawn_structure
+
+#endif // PAWN_STRUCTURE_H
@@ -0,0 +1,453 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "algebraic_notation.h"
+#include "board.h"
+#include "fen.h"
+#include "game.h"
+#include "lawyer.h"
+#include "move.h"
+
+/*
+* Portable Game Notation import/export.
+*
+* pgn::Reader pulls one game at a time out of a stream, so an archive of any size
+* is read in constant memory: only the current game's tags and movetext are held,
+* and they live in a caller-owned GameRecord whose buffers are reused from game to
+* game. Comments ({...} and ;...) and variations ((...), nested) are skipped by
+* default and kept as annotations on request. NAGs, move numbers and %-escaped
+* lines are always dropped.
+*
+* A GameRecord is only text. replay() runs it through a Game (full rules, game
+* status after every move); for_each_position() walks it on a bare Board for bulk
+* ingestion (opening statistics, training data) where only the positions and moves
+* matter. pgn::write() and record_of() go the other way.
+*/
+
+namespace pgn {
+
+struct Tag {
+    std::string name;
+    std::string value;
+};
+
+// A comment or a variation, attached after `ply` moves of the main line.
+struct Annotation {
+    size_t ply;
+    bool variation;    // "(...)" if true, "{...}" otherwise
+    std::string text;  // without the enclosing brackets
+};
+
+struct GameRecord {
+    std::vector<Tag> tags;
+    std::vector<std::string> moves;  // main line, in SAN as written in the file
+    std::vector<Annotation> annotations;
+    std::string result = "*";        // "1-0", "0-1", "1/2-1/2" or "*"
+
+    // Empties the record, keeping allocated capacity.
+    void clear() {
+        tags.clear();
+        moves.clear();
+        annotations.clear();
+        result = "*";
+    }
+
+    // Value of tag `name`, or nullptr if the tag is missing.
+    const std::string* tag(const std::string& name) const {
+        for (const Tag& t : tags) {
+            if (t.name == name) return &t.value;
+        }
+        return nullptr;
+    }
+
+    void set_tag(const std::string& name, const std::string& value) {
+        for (Tag& t : tags) {
+            if (t.name == name) {
+                t.value = value;
+                return;
+            }
+        }
+        tags.push_back(Tag{name, value});
+    }
+};
+
+struct ReaderOptions {
+    bool keep_comments = false;
+    bool keep_variations = false;
+};
+
+class Reader {
+public:
+    explicit Reader(std::istream& in, ReaderOptions options = ReaderOptions())
+        : buf_(in.rdbuf()), options_(options) {}
+
+    // Read the next game into `record`. Returns false at the end of the stream.
+    // Throws std::runtime_error on malformed input, after skipping to the next game, so the
+    // caller can log it and keep reading.
+    bool next(GameRecord& record) {
+        record.clear();
+        bool started = false;
+        while (true) {
+            skip_space();
+            const int c = peek();
+            if (c == EOF) {
+                if (!started) return false;
+                ++games_;  // unterminated last game
+                return true;
+            }
+            if (c == '%' && at_line_start_) {
+                skip_line();
+                continue;
+            }
+            if (c == '[') {
+                if (!record.moves.empty()) fail("tag pair inside movetext");
+                read_tag(record);
+                started = true;
+                continue;
+            }
+            started = true;
+            if (c == '{') {
+                get();
+                read_comment('}', record);
+            } else if (c == ';') {
+                get();
+                read_comment('\n', record);
+            } else if (c == '(') {
+                get();
+                read_variation(record);
+            } else if (c == ')') {
+                fail("unbalanced ')'");
+            } else if (c == '$') {
+                get();
+                while (is_digit(peek())) get();
+            } else {
+                read_symbol();
+                if (symbol_ == "1-0" || symbol_ == "0-1" || symbol_ == "1/2-1/2" || symbol_ == "*") {
+                    record.result = symbol_;
+                    ++games_;
+                    return true;
+                }
+                strip_move_number();
+                if (!symbol_.empty()) record.moves.push_back(symbol_);
+            }
+        }
+    }
+
+    // Games read so far, and the current line (for error messages)
+    size_t games_read(void) const { return games_; }
+    size_t line(void) const { return line_; }
+
+private:
+    std::streambuf* buf_;
+    ReaderOptions options_;
+    std::string symbol_;
+    std::string text_;
+    size_t games_ = 0;
+    size_t line_ = 1;
+    bool at_line_start_ = true;
+
+    static bool is_digit(int c) { return c >= '0' && c <= '9'; }
+    static bool is_space(int c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+    int peek(void) { return buf_->sgetc(); }
+    int get(void) {
+        const int c = buf_->sbumpc();
+        if (c == '\n') {
+            ++line_;
+            at_line_start_ = true;
+        } else if (c != EOF) {
+            at_line_start_ = false;
+        }
+        return c;
+    }
+
+    [[noreturn]] void fail(const std::string& what) {
+        const size_t line = line_;
+        // Resynchronise on the next game. A tag pair opening the current line already is one
+        // (a game missing its result runs into the next game's tags); otherwise skip to the
+        // next tag pair after a blank line.
+        if (!(at_line_start_ && peek() == '[')) {
+            bool blank = false;
+            while (true) {
+                skip_line();
+                const int c = peek();
+                if (c == EOF || (c == '[' && blank)) break;
+                blank = (c == '\n' || c == '\r');
+            }
+        }
+        throw std::runtime_error("PGN: " + what + " at line " + std::to_string(line));
+    }
+
+    void skip_space(void) {
+        while (is_space(peek())) get();
+    }
+
+    void skip_line(void) {
+        int c;
+        do { c = get(); } while (c != '\n' && c != EOF);
+    }
+
+    // [Name "value"]
+    void read_tag(GameRecord& record) {
+        get();  // '['
+        skip_space();
+        Tag tag;
+        while (peek() != EOF && !is_space(peek()) && peek() != '"' && peek() != ']') {
+            tag.name.push_back(static_cast<char>(get()));
+        }
+        if (tag.name.empty()) fail("tag without a name");
+        skip_space();
+        if (get() != '"') fail("tag value must be quoted");
+        while (true) {
+            int c = get();
+            if (c == EOF || c == '\n') fail("unterminated tag value");
+            if (c == '"') break;
+            if (c == '\\') {
+                c = get();
+                if (c == EOF) fail("unterminated tag value");
+            }
+            tag.value.push_back(static_cast<char>(c));
+        }
+        skip_space();
+        if (get() != ']') fail("tag pair not closed");
+        record.tags.push_back(std::move(tag));
+    }
+
+    // Comment body up to `end` (consumed).
+    void read_comment(int end, GameRecord& record) {
+        text_.clear();
+        while (true) {
+            const int c = get();
+            if (c == EOF) {
+                if (end == '\n') break;
+                fail("unterminated comment");
+            }
+            if (c == end) break;
+            if (options_.keep_comments) text_.push_back(static_cast<char>(c));
+        }
+        if (options_.keep_comments) {
+            record.annotations.push_back(Annotation{record.moves.size(), false, text_});
+        }
+    }
+
+    // Everything up to the matching ')', kept verbatim if asked to.
+    void read_variation(GameRecord& record) {
+        text_.clear();
+        int depth = 1;
+        bool in_comment = false;
+        while (true) {
+            const int c = get();
+            if (c == EOF) fail("unterminated variation");
+            if (in_comment) {
+                if (c == '}') in_comment = false;
+            } else if (c == '{') {
+                in_comment = true;
+            } else if (c == '(') {
+                ++depth;
+            } else if (c == ')') {
+                if (--depth == 0) break;
+            }
+            if (options_.keep_variations) text_.push_back(static_cast<char>(c));
+        }
+        if (options_.keep_variations) {
+            record.annotations.push_back(Annotation{record.moves.size(), true, text_});
+        }
+    }
+
+    void read_symbol(void) {
+        symbol_.clear();
+        while (true) {
+            const int c = peek();
+            if (c == EOF || is_space(c) || c == '{' || c == '(' || c == ')' || c == ';' || c == '$' || c == '[') break;
+            symbol_.push_back(static_cast<char>(get()));
+        }
+        if (symbol_.empty()) {
+            // Some other stray character, don't loop on it
+            symbol_.push_back(static_cast<char>(get()));
+            fail("unexpected character '" + symbol_ + "'");
+        }
+    }
+
+    // "12." / "12..." prefixes, possibly glued to the move ("12.e4")
+    void strip_move_number(void) {
+        size_t i = 0;
+        while (i < symbol_.size() && is_digit(symbol_[i])) ++i;
+        if (i == symbol_.size() || symbol_[i] != '.') return;
+        while (i < symbol_.size() && symbol_[i] == '.') ++i;
+        symbol_.erase(0, i);
+    }
+};
+
+namespace pgn_detail {
+
+// Starting position of a record: its FEN tag if there is one, the standard position otherwise.
+inline void starting_position(const GameRecord& record, Board& board, int& halfmove_clock, int& fullmove_number) {
+    const std::string* start = record.tag("FEN");
+    if (start != nullptr) {
+        fen::parse(*start, board, halfmove_clock, fullmove_number);
+    } else {
+        board.reset();
+        halfmove_clock = 0;
+        fullmove_number = 1;
+    }
+}
+
+[[noreturn]] inline void illegal_move(const GameRecord& record, size_t ply) {
+    throw std::runtime_error("PGN: illegal or ambiguous move " + std::to_string(ply / 2 + 1) +
+                             (ply % 2 == 0 ? ". " : "... ") + record.moves[ply]);
+}
+
+inline void append_escaped(std::string& out, const std::string& value) {
+    for (char c : value) {
+        if (c == '"' || c == '\\') out.push_back('\\');
+        out.push_back(c);
+    }
+}
+
+} // namespace pgn_detail
+
+// Replay the main line of `record` into `game`, starting from its FEN tag if present.
+// Throws std::runtime_error on a bad FEN or an illegal move; `game` then holds the moves before it.
+inline void replay(const GameRecord& record, Game& game) {
+    const std::string* start = record.tag("FEN");
+    if (start != nullptr) {
+        game.load_fen(*start);
+    } else {
+        game.reset();
+    }
+    for (size_t ply = 0; ply < record.moves.size(); ++ply) {
+        const auto move = from_algebraic_notation(game.board(), record.moves[ply]);
+        if (!move.has_value() || game.verify_and_move(move.value()) != 0) {
+            pgn_detail::illegal_move(record, ply);
+        }
+    }
+}
+
+/*
+* Walk the main line on a bare board, calling visit(board, move) with each position
+* before its move is played. No game status, repetition or undo bookkeeping, which is
+* what makes this the fast path for bulk ingestion. `board` is caller-owned scratch,
+* reused across games. Throws std::runtime_error on a bad FEN or an illegal move.
+*/
+template <typename Visitor>
+void for_each_position(const GameRecord& record, Board& board, Visitor&& visit) {
+    int halfmove_clock = 0;
+    int fullmove_number = 1;
+    pgn_detail::starting_position(record, board, halfmove_clock, fullmove_number);
+    Lawyer& lawyer = Lawyer::instance();
+    for (size_t ply = 0; ply < record.moves.size(); ++ply) {
+        const auto move = from_algebraic_notation(board, record.moves[ply]);
+        if (!move.has_value()) pgn_detail::illegal_move(record, ply);
+        visit(static_cast<const Board&>(board), move.value());
+        lawyer.perform_legal_move(board, move.value());
+    }
+}
+
+// Record of a game played so far, with `tags` first (Result, FEN and SetUp are filled in).
+inline GameRecord record_of(const Game& game, const std::vector<Tag>& tags = {}) {
+    GameRecord record;
+    record.tags = tags;
+    switch (game.winner()) {
+        case GameWinner::White: record.result = "1-0"; break;
+        case GameWinner::Black: record.result = "0-1"; break;
+        case GameWinner::Draw: record.result = "1/2-1/2"; break;
+        default: record.result = "*"; break;
+    }
+    record.set_tag("Result", record.result);
+
+    const std::string start = game.starting_fen();
+    if (start != fen::STARTING_POSITION) {
+        record.set_tag("SetUp", "1");
+        record.set_tag("FEN", start);
+    }
+
+    Board board(game.starting_board());
+    board.detach_accumulator();
+    Lawyer& lawyer = Lawyer::instance();
+    record.moves.reserve(game.moves().size());
+    for (const Move& move : game.moves()) {
+        record.moves.push_back(to_algebraic_notation(move, board, SanSuffix::Check));
+        lawyer.perform_legal_move(board, move);
+    }
+    return record;
+}
+
+// Append `record` as PGN to `out`: tags, a blank line, movetext wrapped at 80 columns,
+// and a blank line after the result.
+inline void write(const GameRecord& record, std::string& out) {
+    for (const Tag& tag : record.tags) {
+        out += '[';
+        out += tag.name;
+        out += " \"";
+        pgn_detail::append_escaped(out, tag.value);
+        out += "\"]\n";
+    }
+    out += '\n';
+
+    // Move numbers follow the FEN tag, if any
+    int fullmove_number = 1;
+    bool white_to_move = true;
+    if (const std::string* start = record.tag("FEN")) {
+        Board board;
+        int halfmove_clock = 0;
+        fen::parse(*start, board, halfmove_clock, fullmove_number);
+        white_to_move = board.is_white_to_move();
+    }
+
+    size_t line_start = out.size();
+    auto emit = [&](const std::string& token) {
+        if (out.size() > line_start) {
+            if (out.size() - line_start + 1 + token.size() > 79) {
+                out += '\n';
+                line_start = out.size();
+            } else {
+                out += ' ';
+            }
+        }
+        out += token;
+    };
+
+    size_t next_annotation = 0;
+    auto emit_annotations = [&](size_t ply) {
+        for (; next_annotation < record.annotations.size() && record.annotations[next_annotation].ply == ply; ++next_annotation) {
+            const Annotation& a = record.annotations[next_annotation];
+            emit(a.variation ? "(" + a.text + ")" : "{" + a.text + "}");
+        }
+    };
+
+    bool number_needed = true;  // after a comment black's move needs its "N..." again
+    for (size_t ply = 0; ply < record.moves.size(); ++ply) {
+        const size_t annotations_before = next_annotation;
+        emit_annotations(ply);
+        if (next_annotation != annotations_before) number_needed = true;
+        if (white_to_move) {
+            emit(std::to_string(fullmove_number) + ". " + record.moves[ply]);
+        } else if (number_needed) {
+            emit(std::to_string(fullmove_number) + "... " + record.moves[ply]);
+        } else {
+            emit(record.moves[ply]);
+        }
+        number_needed = false;
+        if (!white_to_move) ++fullmove_number;
+        white_to_move = !white_to_move;
+    }
+    emit_annotations(record.moves.size());
+    emit(record.result);
+    out += "\n\n";
+}
+
+inline void write(const GameRecord& record, std::ostream& out) {
+    std::string text;
+    write(record, text);
+    out << text;
+}
+
+} // namespace pgn
+
+#endif // PGN_H
@@ -0,0 +1,484 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "board.h"
+#include "piece.h"
+
+/*
+* Endgame tablebases: exact distance to mate for every position of a material
+* signature such as "KQvK" or "KRvKP" (kings first, then Q, R, B, N, P).
+*
+* Only one orientation of each signature is stored, with the stronger side as
+* white; positions with the colours the other way round are probed mirrored.
+* Tables assume no castling rights and no en-passant capture.
+*
+* Index layout, from the most significant digit down:
+*   white king slot, black king square, the other pieces' squares (white's in
+*   signature order, then black's), side to move (lowest bit, so both sides of
+*   a position share a cache line).
+* Symmetry shrinks the white king slot: without pawns the board is rotated and
+* reflected so the white king is in the a1-d1-d4 triangle (10 slots), with pawns
+* it is only mirrored left to right (files a-d, 32 slots). Indices whose position
+* is illegal, or that are not the canonical form of their position, hold INVALID.
+*
+* Each entry is a uint16 code: DRAW, INVALID, or 2 + the number of plies to mate.
+* An even number of plies means the side to move gets mated, odd means it mates.
+*
+* File layout (little-endian): 8-byte magic "JCOTB001", 16-byte signature name
+* (zero padded), uint64 entry count, then the entries.
+*/
+
+namespace tablebase {
+
+inline constexpr char FILE_MAGIC[8] = {'J', 'C', 'O', 'T', 'B', '0', '0', '1'};
+inline constexpr size_t HEADER_SIZE = 32;
+inline constexpr uint16_t DRAW = 0;
+inline constexpr uint16_t INVALID = 1;
+inline constexpr int MAX_PIECES = 4;
+
+// Plies to mate from a code, for codes other than DRAW and INVALID
+inline int plies_to_mate(uint16_t code) { return code - 2; }
+inline uint16_t code_for_plies(int plies) { return static_cast<uint16_t>(plies + 2); }
+inline bool is_win(uint16_t code) { return code >= 2 && plies_to_mate(code) % 2 == 1; }
+inline bool is_loss(uint16_t code) { return code >= 2 && plies_to_mate(code) % 2 == 0; }
+
+inline int kind_order(PieceKind kind) {
+    switch (kind) {
+        case PieceKind::King: return 0;
+        case PieceKind::Queen: return 1;
+        case PieceKind::Rook: return 2;
+        case PieceKind::Bishop: return 3;
+        case PieceKind::Knight: return 4;
+        case PieceKind::Pawn: return 5;
+    }
+    return 6;
+}
+
+inline int kind_value(PieceKind kind) {
+    switch (kind) {
+        case PieceKind::Queen: return 9;
+        case PieceKind::Rook: return 5;
+        case PieceKind::Bishop: return 3;
+        case PieceKind::Knight: return 3;
+        case PieceKind::Pawn: return 1;
+        default: return 0;
+    }
+}
+
+// The pieces of each side, king first, in signature order.
+struct Material {
+    std::vector<PieceKind> white;
+    std::vector<PieceKind> black;
+
+    int piece_count(void) const { return static_cast<int>(white.size() + black.size()); }
+
+    bool has_pawns(void) const {
+        return std::count(white.begin(), white.end(), PieceKind::Pawn) + std::count(black.begin(), black.end(), PieceKind::Pawn) > 0;
+    }
+
+    std::string name(void) const {
+        std::string out;
+        for (PieceKind k : white) out.push_back(kind_to_char(k));
+        out.push_back('v');
+        for (PieceKind k : black) out.push_back(kind_to_char(k));
+        return out;
+    }
+
+    // Whether this is the stored orientation: white has more pieces, or more value, or equal material.
+    bool canonical(void) const {
+        if (white.size() != black.size()) return white.size() > black.size();
+        int white_value = 0, black_value = 0;
+        for (PieceKind k : white) white_value += kind_value(k);
+        for (PieceKind k : black) black_value += kind_value(k);
+        if (white_value != black_value) return white_value > black_value;
+        for (size_t i = 0; i < white.size(); ++i) {
+            if (white[i] != black[i]) return kind_order(white[i]) < kind_order(black[i]);
+        }
+        return true;
+    }
+
+    Material flipped(void) const { return Material{black, white}; }
+
+    friend bool operator==(const Material& lhs, const Material& rhs) {
+        return lhs.white == rhs.white && lhs.black == rhs.black;
+    }
+};
+
+inline void sort_kinds(std::vector<PieceKind>& kinds) {
+    std::sort(kinds.begin(), kinds.end(), [](PieceKind a, PieceKind b) { return kind_order(a) < kind_order(b); });
+}
+
+inline Material material_of(const Board& board) {
+    Material m;
+    for (int i = 0; i < board.get_piece_count(); ++i) {
+        const Piece& p = board.get_piece(i);
+        (p.white ? m.white : m.black).push_back(p.kind);
+    }
+    sort_kinds(m.white);
+    sort_kinds(m.black);
+    return m;
+}
+
+// "KRvKP" -> Material. Throws std::runtime_error on anything else.
+inline Material parse_material(const std::string& name) {
+    Material m;
+    bool black = false;
+    for (char c : name) {
+        if (c == 'v') {
+            if (black) throw std::runtime_error("Bad material signature " + name);
+            black = true;
+            continue;
+        }
+        const PieceKind kind = char_to_kind(c);
+        (black ? m.black : m.white).push_back(kind);
+    }
+    sort_kinds(m.white);
+    sort_kinds(m.black);
+    auto one_king = [](const std::vector<PieceKind>& side) {
+        return std::count(side.begin(), side.end(), PieceKind::King) == 1;
+    };
+    if (!black || !one_king(m.white) || !one_king(m.black) || m.piece_count() > MAX_PIECES) {
+        throw std::runtime_error("Bad material signature " + name);
+    }
+    return m;
+}
+
+/*
+* Index <-> position mapping for one (canonical) material signature.
+*/
+class Layout {
+public:
+    explicit Layout(const Material& material) : material_(material), pawns_(material.has_pawns()) {
+        slots_ = 0;
+        add_slot(PieceKind::King, true);
+        add_slot(PieceKind::King, false);
+        for (size_t i = 1; i < material.white.size(); ++i) add_slot(material.white[i], true);
+        for (size_t i = 1; i < material.black.size(); ++i) add_slot(material.black[i], false);
+        king_slots_ = pawns_ ? 32 : 10;
+        size_ = static_cast<uint64_t>(king_slots_) * 2;
+        for (int i = 1; i < slots_; ++i) size_ *= 64;
+    }
+
+    const Material& material(void) const { return material_; }
+    uint64_t size(void) const { return size_; }
+
+    /*
+    * Index of `board` (which must have this material, or its mirror if `flip_colours`).
+    * With flip_colours the board is read with colours swapped and ranks mirrored.
+    */
+    uint64_t encode(const Board& board, bool flip_colours = false) const {
+        int squares[MAX_PIECES];
+        bool filled[MAX_PIECES] = {false, false, false, false};
+        for (int i = 0; i < board.get_piece_count(); ++i) {
+            const Piece& p = board.get_piece(i);
+            const bool white = flip_colours ? !p.white : p.white;
+            const int y = flip_colours ? 7 - p.y : p.y;
+            for (int s = 0; s < slots_; ++s) {
+                if (filled[s] || kinds_[s] != p.kind || whites_[s] != white) continue;
+                squares[s] = y * 8 + p.x;
+                filled[s] = true;
+                break;
+            }
+        }
+        const bool white_to_move = flip_colours ? !board.is_white_to_move() : board.is_white_to_move();
+        return encode_squares(squares, white_to_move);
+    }
+
+    // Place the position of `index` on `board`. False if squares clash or a pawn is on a back rank.
+    bool decode(uint64_t index, Board& board) const {
+        const bool white_to_move = (index & 1) == 0;
+        index >>= 1;
+        int squares[MAX_PIECES];
+        for (int s = slots_ - 1; s >= 1; --s) {
+            squares[s] = static_cast<int>(index % 64);
+            index /= 64;
+        }
+        squares[0] = king_square(static_cast<int>(index));
+        board.clear();
+        for (int s = 0; s < slots_; ++s) {
+            const int x = squares[s] % 8;
+            const int y = squares[s] / 8;
+            if (kinds_[s] == PieceKind::Pawn && (y == 0 || y == 7)) return false;
+            if (board.find_piece_at(x, y) != -1) return false;
+            board.place_piece(Piece(x, y, whites_[s], kinds_[s]));
+        }
+        board.set_white_to_move(white_to_move);
+        return true;
+    }
+
+private:
+    Material material_;
+    bool pawns_;
+    int slots_;
+    PieceKind kinds_[MAX_PIECES];
+    bool whites_[MAX_PIECES];
+    int king_slots_;
+    uint64_t size_;
+
+    void add_slot(PieceKind kind, bool white) {
+        kinds_[slots_] = kind;
+        whites_[slots_] = white;
+        ++slots_;
+    }
+
+    // The 8 symmetries of the board: bit 0 mirrors files, bit 1 mirrors ranks, bit 2 swaps files and ranks.
+    static int transform(int square, int t) {
+        int x = square % 8;
+        int y = square / 8;
+        if (t & 1) x = 7 - x;
+        if (t & 2) y = 7 - y;
+        if (t & 4) std::swap(x, y);
+        return y * 8 + x;
+    }
+
+    static int triangle_slot(int square) {
+        const int x = square % 8;
+        const int y = square / 8;
+        if (x > 3 || y > x) return -1;
+        return x * (x + 1) / 2 + y;  // a1 b1 b2 c1 c2 c3 d1 d2 d3 d4
+    }
+
+    int king_square(int slot) const {
+        if (pawns_) return (slot / 4) * 8 + slot % 4;
+        int x = 0;
+        while ((x + 1) * (x + 2) / 2 <= slot) ++x;
+        return (slot - x * (x + 1) / 2) * 8 + x;
+    }
+
+    // Index of the squares after symmetry `t`, which must bring the white king to its region.
+    uint64_t index_under(const int* squares, int t, bool white_to_move) const {
+        int moved[MAX_PIECES];
+        for (int s = 0; s < slots_; ++s) moved[s] = transform(squares[s], t);
+        // Identical pieces in ascending square order
+        for (int s = 2; s + 1 < slots_; ++s) {
+            if (kinds_[s] == kinds_[s + 1] && whites_[s] == whites_[s + 1] && moved[s] > moved[s + 1]) {
+                std::swap(moved[s], moved[s + 1]);
+            }
+        }
+        uint64_t index = pawns_ ? static_cast<uint64_t>((moved[0] / 8) * 4 + moved[0] % 8)
+                                : static_cast<uint64_t>(triangle_slot(moved[0]));
+        for (int s = 1; s < slots_; ++s) index = index * 64 + static_cast<uint64_t>(moved[s]);
+        return index * 2 + (white_to_move ? 0 : 1);
+    }
+
+    uint64_t encode_squares(const int* squares, bool white_to_move) const {
+        if (pawns_) return index_under(squares, (squares[0] % 8 > 3) ? 1 : 0, white_to_move);
+        // A king on the a1-h8 diagonal is in the triangle both as it is and reflected
+        // along the diagonal; the smaller index of the two is the canonical one.
+        uint64_t best = UINT64_MAX;
+        for (int t = 0; t < 8; ++t) {
+            if (triangle_slot(transform(squares[0], t)) == -1) continue;
+            best = std::min(best, index_under(squares, t, white_to_move));
+        }
+        return best;
+    }
+};
+
+// Entry count and codes of a table file. Throws std::runtime_error if the file does not hold `material`.
+inline std::vector<uint16_t> read_table(const std::string& path, const Material& material) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("tablebase::read_table: cannot open " + path);
+    }
+    char header[HEADER_SIZE];
+    in.read(header, sizeof(header));
+    if (!in || std::memcmp(header, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+        throw std::runtime_error("tablebase::read_table: bad magic in " + path);
+    }
+    uint64_t count = 0;
+    std::memcpy(&count, header + 24, sizeof(count));
+    if (std::string(header + 8, strnlen(header + 8, 16)) != material.name() || count != Layout(material).size()) {
+        throw std::runtime_error("tablebase::read_table: " + path + " does not hold " + material.name());
+    }
+    std::vector<uint16_t> codes(count);
+    in.read(reinterpret_cast<char*>(codes.data()), static_cast<std::streamsize>(count * sizeof(uint16_t)));
+    if (!in) {
+        throw std::runtime_error("tablebase::read_table: truncated file " + path);
+    }
+    return codes;
+}
+
+inline void write_table(const std::string& path, const Material& material, const std::vector<uint16_t>& codes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("tablebase::write_table: cannot open " + path);
+    }
+    char header[HEADER_SIZE] = {};
+    std::memcpy(header, FILE_MAGIC, sizeof(FILE_MAGIC));
+    const std::string name = material.name();
+    std::memcpy(header + 8, name.data(), std::min<size_t>(name.size(), 16));
+    const uint64_t count = codes.size();
+    std::memcpy(header + 24, &count, sizeof(count));
+    out.write(header, sizeof(header));
+    out.write(reinterpret_cast<const char*>(codes.data()), static_cast<std::streamsize>(count * sizeof(uint16_t)));
+    if (!out) {
+        throw std::runtime_error("tablebase::write_table: write failed for " + path);
+    }
+}
+
+inline std::string file_name(const Material& material) { return material.name() + ".jtb"; }
+
+/*
+* Read-only access to a directory of table files for probing during search.
+*
+* Every table is mmap'ed when the directory is opened; nothing is read until a
+* probe touches it. Probes are random accesses over files of up to tens of
+* megabytes, so the pages touched last are kept in a small LRU and the
+* least recently used page is handed back to the kernel (MADV_DONTNEED) when it
+* falls out: the resident set stays at the hot pages however long the search runs.
+*/
+class Tablebase {
+public:
+    static std::shared_ptr<const Tablebase> open(const std::string& directory, size_t cached_pages = 1024) {
+        std::shared_ptr<Tablebase> tb(new Tablebase(cached_pages));
+        std::error_code ec;
+        for (const auto& file : std::filesystem::directory_iterator(directory, ec)) {
+            if (file.path().extension() != ".jtb") continue;
+            tb->map(file.path().string(), parse_material(file.path().stem().string()));
+        }
+        if (ec) {
+            throw std::runtime_error("tablebase::Tablebase::open: cannot read " + directory);
+        }
+        return tb;
+    }
+
+    ~Tablebase() {
+        for (const Mapped& m : tables_) ::munmap(m.base, m.size);
+    }
+    Tablebase(const Tablebase&) = delete;
+    Tablebase& operator=(const Tablebase&) = delete;
+
+    // Largest piece count with at least one table, 0 if there are none.
+    int max_pieces(void) const { return max_pieces_; }
+    size_t table_count(void) const { return tables_.size(); }
+
+    /*
+    * Code of `board` for the side to move (see the top of this file), or nullopt if no
+    * table covers it: its material is missing, castling is still allowed, or an
+    * en-passant capture is possible.
+    */
+    std::optional<uint16_t> probe(const Board& board) const {
+        if (board.get_piece_count() > max_pieces_) return std::nullopt;
+        const CastlingRights cr = board.get_castling_rights();
+        if (cr.white_kingside || cr.white_queenside || cr.black_kingside || cr.black_queenside) return std::nullopt;
+        if (en_passant_capture_possible(board)) return std::nullopt;
+
+        const Material material = material_of(board);
+        if (material.piece_count() == 2) return DRAW;
+        const bool flip = !material.canonical();
+        const Mapped* table = find(flip ? material.flipped() : material);
+        if (table == nullptr) return std::nullopt;
+        const uint16_t* entry = table->codes + table->layout.encode(board, flip);
+        touch(entry);
+        return *entry;
+    }
+
+private:
+    struct Mapped {
+        Material material;
+        Layout layout;
+        void* base;
+        size_t size;
+        const uint16_t* codes;
+    };
+
+    std::vector<Mapped> tables_;
+    int max_pieces_ = 0;
+    size_t page_size_;
+    size_t cached_pages_;
+    mutable std::mutex lru_mutex_;
+    mutable std::list<uintptr_t> lru_;  // most recent first
+    mutable std::unordered_map<uintptr_t, std::list<uintptr_t>::iterator> lru_index_;
+
+    explicit Tablebase(size_t cached_pages)
+        : page_size_(static_cast<size_t>(::sysconf(_SC_PAGESIZE))), cached_pages_(std::max<size_t>(1, cached_pages)) {}
+
+    void map(const std::string& path, const Material& material) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw std::runtime_error("tablebase::Tablebase: cannot open " + path);
+        }
+        struct stat st;
+        const Layout layout(material);
+        const size_t expected = HEADER_SIZE + layout.size() * sizeof(uint16_t);
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != expected) {
+            ::close(fd);
+            throw std::runtime_error("tablebase::Tablebase: size mismatch in " + path);
+        }
+        void* base = ::mmap(nullptr, expected, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            throw std::runtime_error("tablebase::Tablebase: mmap failed for " + path);
+        }
+        const char* bytes = static_cast<const char*>(base);
+        if (std::memcmp(bytes, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+            std::string(bytes + 8, strnlen(bytes + 8, 16)) != material.name()) {
+            ::munmap(base, expected);
+            throw std::runtime_error("tablebase::Tablebase: " + path + " does not hold " + material.name());
+        }
+        ::madvise(base, expected, MADV_RANDOM);
+        tables_.push_back(Mapped{material, layout, base, expected, reinterpret_cast<const uint16_t*>(bytes + HEADER_SIZE)});
+        max_pieces_ = std::max(max_pieces_, material.piece_count());
+    }
+
+    const Mapped* find(const Material& material) const {
+        for (const Mapped& m : tables_) {
+            if (m.material == material) return &m;
+        }
+        return nullptr;
+    }
+
+    static bool en_passant_capture_possible(const Board& board) {
+        if (!board.has_en_passant()) return false;
+        const EnPassant ep = board.get_en_passant();
+        const bool white = board.is_white_to_move();
+        const int pawn_y = ep.get_y() + (white ? -1 : 1);
+        for (int dx = -1; dx <= 1; dx += 2) {
+            if (!in_bounds(ep.get_x() + dx, pawn_y)) continue;
+            const int idx = board.find_piece_at(ep.get_x() + dx, pawn_y);
+            if (idx == -1) continue;
+            const Piece& p = board.get_piece(idx);
+            if (p.kind == PieceKind::Pawn && p.white == white) return true;
+        }
+        return false;
+    }
+
+    // Record a probe of `entry` in the page LRU, releasing the page that falls out.
+    void touch(const uint16_t* entry) const {
+        const uintptr_t page = reinterpret_cast<uintptr_t>(entry) & ~static_cast<uintptr_t>(page_size_ - 1);
+        std::lock_guard<std::mutex> lock(lru_mutex_);
+        auto found = lru_index_.find(page);
+        if (found != lru_index_.end()) {
+            lru_.splice(lru_.begin(), lru_, found->second);
+            return;
+        }
+        lru_.push_front(page);
+        lru_index_[page] = lru_.begin();
+        if (lru_.size() <= cached_pages_) return;
+        const uintptr_t evicted = lru_.back();
+        lru_.pop_back();
+        lru_index_.erase(evicted);
+        ::madvise(reinterpret_cast<void*>(evicted), page_size_, MADV_DONTNEED);
+    }
+};
+
+} // namespace tablebase
+
+#endif // TABLEBASE_H
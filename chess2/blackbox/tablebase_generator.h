@@ -0,0 +1,289 @@
+#ifndef TABLEBASE_GENERATOR_H
+#define TABLEBASE_GENERATOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "board.h"
+#include "lawyer.h"
+#include "move.h"
+#include "tablebase.h"
+
+/*
+* Retrograde tablebase generation.
+*
+* 1. Every index is decoded and its legal moves generated with the Lawyer. Mates
+*    are known right away. Moves that capture or promote leave the table and are
+*    looked up in smaller (or sibling) tables, which are generated first.
+* 2. Positions are then settled in order of distance to mate, one bucket per
+*    ply count. Settling a position walks its predecessors (un-moves of the side
+*    that just moved): if the settled position is lost for its side to move,
+*    each predecessor wins one ply later; if it is won, each predecessor loses one
+*    more way out, and loses outright once every move has been used up.
+* 3. Whatever is left unsettled is a draw.
+*
+* Both passes are split across threads. Moves and un-moves are counted between
+* canonical indices, so symmetric positions are counted once on both sides.
+*/
+
+namespace tablebase {
+
+class Generator {
+public:
+    // Tables are read from and written to `directory` if it is not empty.
+    explicit Generator(int threads = 1, std::string directory = "")
+        : threads_(std::max(1, threads)), directory_(std::move(directory)) {}
+
+    // Progress messages, e.g. to print them
+    void set_log(std::function<void(const std::string&)> log) { log_ = std::move(log); }
+
+    // Generate (or load) the table for `material` and every table it depends on.
+    const std::vector<uint16_t>& generate(const Material& requested) {
+        const Material material = requested.canonical() ? requested : requested.flipped();
+        const std::string name = material.name();
+        auto found = tables_.find(name);
+        if (found != tables_.end()) return found->second;
+
+        for (const Material& dependency : dependencies(material)) generate(dependency);
+
+        const std::string path = directory_.empty() ? "" : (std::filesystem::path(directory_) / file_name(material)).string();
+        if (!path.empty() && std::filesystem::exists(path)) {
+            if (log_) log_("Loading " + name);
+            return tables_.emplace(name, read_table(path, material)).first->second;
+        }
+        if (log_) log_("Generating " + name);
+        std::vector<uint16_t> codes = build(material);
+        if (!path.empty()) write_table(path, material, codes);
+        return tables_.emplace(name, std::move(codes)).first->second;
+    }
+
+    // Code of `board` from the generated tables, for the side to move.
+    uint16_t probe(const Board& board) const {
+        const Material material = material_of(board);
+        if (material.piece_count() == 2) return DRAW;
+        const bool flip = !material.canonical();
+        const Material stored = flip ? material.flipped() : material;
+        auto found = tables_.find(stored.name());
+        if (found == tables_.end()) {
+            throw std::runtime_error("tablebase::Generator::probe: " + stored.name() + " not generated");
+        }
+        return found->second[Layout(stored).encode(board, flip)];
+    }
+
+    // Every table reachable from `material` by one capture or promotion, canonically oriented.
+    static std::vector<Material> dependencies(const Material& material) {
+        std::vector<Material> out;
+        auto add = [&](Material m) {
+            sort_kinds(m.white);
+            sort_kinds(m.black);
+            if (m.piece_count() == 2) return;
+            if (!m.canonical()) m = m.flipped();
+            if (m == material || std::find(out.begin(), out.end(), m) != out.end()) return;
+            out.push_back(m);
+        };
+        for (int side = 0; side < 2; ++side) {
+            const std::vector<PieceKind>& pieces = side == 0 ? material.white : material.black;
+            for (size_t i = 1; i < pieces.size(); ++i) {
+                Material captured = material;
+                std::vector<PieceKind>& own = side == 0 ? captured.white : captured.black;
+                own.erase(own.begin() + static_cast<long>(i));
+                add(captured);
+                if (pieces[i] != PieceKind::Pawn) continue;
+                for (PieceKind promotion : promoKinds) {
+                    Material promoted = material;
+                    (side == 0 ? promoted.white : promoted.black)[i] = promotion;
+                    add(promoted);
+                }
+            }
+        }
+        return out;
+    }
+
+private:
+    static constexpr uint16_t UNKNOWN = 0xFFFF;
+    static constexpr uint16_t ESCAPE = 0xFFFF;  // in exit_: some move draws or wins, never a loss
+
+    int threads_;
+    std::string directory_;
+    std::function<void(const std::string&)> log_;
+    std::map<std::string, std::vector<uint16_t>> tables_;
+
+    using Buckets = std::vector<std::vector<uint64_t>>;
+
+    static void push(Buckets& buckets, int plies, uint64_t index) {
+        if (plies >= static_cast<int>(buckets.size())) buckets.resize(plies + 1);
+        buckets[plies].push_back(index);
+    }
+
+    // Run fn(begin, end, local_buckets) over [0, count) on all threads, then merge the buckets.
+    void parallel(uint64_t count, Buckets& buckets, const std::function<void(uint64_t, uint64_t, Buckets&)>& fn) const {
+        std::vector<Buckets> local(threads_);
+        std::vector<std::thread> workers;
+        std::mutex error_mutex;
+        std::string error;
+        const uint64_t chunk = (count + threads_ - 1) / threads_;
+        for (int t = 0; t < threads_; ++t) {
+            const uint64_t begin = std::min(count, chunk * t);
+            const uint64_t end = std::min(count, begin + chunk);
+            workers.emplace_back([&, t, begin, end] {
+                try {
+                    fn(begin, end, local[t]);
+                } catch (const std::exception& ex) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    error = ex.what();
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        if (!error.empty()) throw std::runtime_error(error);
+        for (const Buckets& mine : local) {
+            for (size_t plies = 0; plies < mine.size(); ++plies) {
+                for (uint64_t index : mine[plies]) push(buckets, static_cast<int>(plies), index);
+            }
+        }
+    }
+
+    // Canonical indices of the positions the side not to move could have come from, without captures.
+    static void predecessors(const Layout& layout, const Board& board, Board& scratch, std::vector<uint64_t>& out) {
+        out.clear();
+        const bool mover_white = !board.is_white_to_move();
+        for (int i = 0; i < board.get_piece_count(); ++i) {
+            const Piece& p = board.get_piece(i);
+            if (p.white != mover_white) continue;
+            auto add = [&](int fx, int fy) {
+                scratch = board;
+                scratch.teletransport_piece(i, fx, fy);
+                scratch.set_white_to_move(mover_white);
+                out.push_back(layout.encode(scratch));
+            };
+            if (p.kind == PieceKind::Pawn) {
+                const int dir = p.white ? 1 : -1;
+                const int one = p.y - dir;
+                if (one < 1 || one > 6 || board.find_piece_at(p.x, one) != -1) continue;
+                add(p.x, one);
+                const int two = p.y - 2 * dir;
+                if (p.y == (p.white ? 3 : 4) && board.find_piece_at(p.x, two) == -1) add(p.x, two);
+                continue;
+            }
+            for (const auto& [fx, fy] : board.get_targets(i)) {
+                if (board.find_piece_at(fx, fy) != -1) continue;  // only a capture could come from there
+                add(fx, fy);
+            }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+    std::vector<uint16_t> build(const Material& material) const {
+        const Layout layout(material);
+        const uint64_t size = layout.size();
+        std::vector<uint16_t> codes(size, UNKNOWN);
+        std::vector<uint16_t> exits(size, 0);  // longest way out of the table that loses, or ESCAPE
+        std::unique_ptr<std::atomic<uint8_t>[]> remaining(new std::atomic<uint8_t>[size]);
+        Buckets buckets;
+
+        // Pass 1: legal moves of every position
+        parallel(size, buckets, [&](uint64_t begin, uint64_t end, Buckets& local) {
+            Lawyer& lawyer = Lawyer::instance();
+            Board board;
+            Board child;
+            std::vector<uint64_t> children;
+            for (uint64_t index = begin; index < end; ++index) {
+                remaining[index].store(0, std::memory_order_relaxed);
+                if (!layout.decode(index, board) || layout.encode(board) != index ||
+                    board.is_player_in_check(!board.is_white_to_move())) {
+                    codes[index] = INVALID;
+                    continue;
+                }
+                const std::vector<Move> moves = lawyer.legal_moves(board);
+                if (moves.empty()) {
+                    if (board.is_player_in_check(board.is_white_to_move())) {
+                        push(local, 0, index);  // mated
+                    }
+                    exits[index] = ESCAPE;  // stalemate stays a draw
+                    continue;
+                }
+                children.clear();
+                bool escape = false;
+                int best_exit_win = -1;
+                int longest_exit_loss = 0;
+                for (const Move& move : moves) {
+                    child = board;
+                    lawyer.perform_legal_move(child, move);
+                    if (!move.is_attempted_capture() && !move.is_attempted_promotion()) {
+                        children.push_back(layout.encode(child));
+                        continue;
+                    }
+                    const uint16_t code = probe(child);
+                    if (code == DRAW) {
+                        escape = true;
+                    } else if (is_loss(code)) {
+                        const int plies = plies_to_mate(code) + 1;
+                        if (best_exit_win == -1 || plies < best_exit_win) best_exit_win = plies;
+                    } else {
+                        longest_exit_loss = std::max(longest_exit_loss, plies_to_mate(code) + 1);
+                    }
+                }
+                std::sort(children.begin(), children.end());
+                children.erase(std::unique(children.begin(), children.end()), children.end());
+                remaining[index].store(static_cast<uint8_t>(children.size()), std::memory_order_relaxed);
+                if (best_exit_win != -1) {
+                    push(local, best_exit_win, index);
+                    escape = true;
+                }
+                exits[index] = escape ? ESCAPE : static_cast<uint16_t>(longest_exit_loss);
+                if (children.empty() && !escape) push(local, longest_exit_loss, index);
+            }
+        });
+
+        // Pass 2: settle positions by distance to mate
+        std::vector<uint64_t> frontier;
+        for (size_t plies = 0; plies < buckets.size(); ++plies) {
+            frontier.clear();
+            for (uint64_t index : buckets[plies]) {
+                if (codes[index] != UNKNOWN) continue;
+                codes[index] = code_for_plies(static_cast<int>(plies));
+                frontier.push_back(index);
+            }
+            std::vector<uint64_t>().swap(buckets[plies]);
+            if (frontier.empty()) continue;
+
+            const bool settled_lost = plies % 2 == 0;
+            parallel(frontier.size(), buckets, [&](uint64_t begin, uint64_t end, Buckets& local) {
+                Board board;
+                Board scratch;
+                std::vector<uint64_t> parents;
+                for (uint64_t i = begin; i < end; ++i) {
+                    layout.decode(frontier[i], board);
+                    predecessors(layout, board, scratch, parents);
+                    for (uint64_t parent : parents) {
+                        if (codes[parent] != UNKNOWN) continue;
+                        if (settled_lost) {
+                            push(local, static_cast<int>(plies) + 1, parent);
+                        } else if (remaining[parent].fetch_sub(1) == 1 && exits[parent] != ESCAPE) {
+                            push(local, std::max(static_cast<int>(plies), static_cast<int>(exits[parent])) + 1, parent);
+                        }
+                    }
+                }
+            });
+        }
+
+        for (uint16_t& code : codes) {
+            if (code == UNKNOWN) code = DRAW;
+        }
+        return codes;
+    }
+};
+
+} // namespace tablebase
+
+#endif // TABLEBASE_GENERATOR_H
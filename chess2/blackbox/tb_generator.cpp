@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "tablebase_generator.h"
+
+/*
+* tb_generator
+* Generates endgame tables (see tablebase.h) into a directory, together with
+* every smaller table they depend on. Existing files are reused.
+*
+*   tb_generator -d tables [-j threads] KQvK KRvKP ...
+*   tb_generator -d tables --all 4
+*/
+
+static void usage(void) {
+    std::cerr << "usage: tb_generator -d <directory> [-j <threads>] (--all <3|4> | <signature>...)\n";
+}
+
+// Every canonical signature with exactly `pieces` pieces
+static std::vector<tablebase::Material> all_materials(int pieces) {
+    const std::vector<PieceKind> kinds = {PieceKind::Queen, PieceKind::Rook, PieceKind::Bishop, PieceKind::Knight, PieceKind::Pawn};
+    std::vector<tablebase::Material> out;
+    auto add = [&](tablebase::Material m) {
+        tablebase::sort_kinds(m.white);
+        tablebase::sort_kinds(m.black);
+        if (!m.canonical()) m = m.flipped();
+        if (std::find(out.begin(), out.end(), m) == out.end()) out.push_back(m);
+    };
+    for (PieceKind a : kinds) {
+        if (pieces == 3) {
+            add(tablebase::Material{{PieceKind::King, a}, {PieceKind::King}});
+            continue;
+        }
+        for (PieceKind b : kinds) {
+            add(tablebase::Material{{PieceKind::King, a, b}, {PieceKind::King}});
+            add(tablebase::Material{{PieceKind::King, a}, {PieceKind::King, b}});
+        }
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    std::string directory;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<tablebase::Material> requested;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool has_value = i + 1 < argc;
+            if ((arg == "-d" || arg == "--directory") && has_value) {
+                directory = argv[++i];
+            } else if ((arg == "-j" || arg == "--threads") && has_value) {
+                threads = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--all" && has_value) {
+                const int pieces = std::stoi(argv[++i]);
+                if (pieces < 3 || pieces > tablebase::MAX_PIECES) throw std::runtime_error("--all takes 3 or 4");
+                for (int n = 3; n <= pieces; ++n) {
+                    for (const auto& m : all_materials(n)) requested.push_back(m);
+                }
+            } else if (!arg.empty() && arg[0] == '-') {
+                usage();
+                return 1;
+            } else {
+                requested.push_back(tablebase::parse_material(arg));
+            }
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << "\n";
+        usage();
+        return 1;
+    }
+    if (directory.empty() || requested.empty()) {
+        usage();
+        return 1;
+    }
+
+    try {
+        std::filesystem::create_directories(directory);
+        tablebase::Generator generator(threads, directory);
+        auto start = std::chrono::steady_clock::now();
+        generator.set_log([&](const std::string& message) {
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "[" << static_cast<int>(seconds) << "s] " << message << std::endl;
+        });
+        for (const auto& material : requested) generator.generate(material);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+#ifndef TESTS_ALGEBRAIC_NOTATION_H
+#define TESTS_ALGEBRAIC_NOTATION_H
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../algebraic_notation.h"
+#include "../fen.h"
+#include "../game.h"
+#include "../lawyer.h"
+
+namespace tests {
+
+inline void san_round_trip_test() {
+    const std::vector<std::string> positions = {
+        fen::STARTING_POSITION,
+        // promotions with and without capture, en passant, castling both ways, twin knights
+        "r3k2r/1P4P1/8/3pP3/8/2N3N1/8/R3K2R w KQkq d6 0 1",
+        "r3k2r/8/2n3n1/8/3Pp3/8/1p4p1/R3K2R b KQkq d3 0 1",
+        // three queens that can reach the same squares
+        "k7/8/8/1Q3Q2/8/8/8/1Q5K w - - 0 1",
+    };
+    for (const auto& position : positions) {
+        Game game;
+        game.load_fen(position);
+        const std::vector<Move> legal_moves = Lawyer::instance().legal_moves(game.board());
+        for (const Move& move : legal_moves) {
+            const std::string san = to_algebraic_notation(move, game.board(), legal_moves);
+            if (san != to_algebraic_notation(move, game.board())) {
+                throw std::runtime_error("[san_round_trip] Move list and board disambiguation disagree on " + san);
+            }
+            const auto parsed = from_algebraic_notation(game.board(), san);
+            if (!parsed.has_value() || !(parsed.value() == move)) {
+                throw std::runtime_error("[san_round_trip] Could not parse back " + san + " in " + position);
+            }
+        }
+    }
+}
+
+inline void san_parser_forms_test() {
+    Game game;
+    game.load_fen("r3k2r/1P4P1/8/3pP3/8/2N3N1/8/R3K2R w KQkq d6 0 1");
+    const Board& board = game.board();
+    auto expect = [&](const std::string& san, bool ok) {
+        if (from_algebraic_notation(board, san).has_value() != ok) {
+            throw std::runtime_error("[san_parser_forms] Unexpected result for " + san);
+        }
+    };
+    expect("0-0", true);
+    expect("O-O-O+", true);
+    expect("bxa8Q", true);
+    expect("gxh8=N", true);
+    expect("exd6", true);
+    expect("Nge4!?", true);
+    expect("Nc3e4", true);
+    expect("Ne4", false);     // ambiguous
+    expect("Nxe4", false);    // ambiguous, and not a capture
+    expect("b8", false);      // promotion piece missing
+    expect("e6=Q", false);    // not a promotion
+    expect("Nge5", false);    // unreachable
+    expect("Zf3", false);
+    expect("", false);
+}
+
+inline void san_suffix_modes_test() {
+    Game game;
+    game.load_fen("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    const Board& board = game.board();
+    const std::vector<Move> legal_moves = Lawyer::instance().legal_moves(board);
+    auto expect = [&](const std::string& san, SanSuffix suffix, const std::string& expected) {
+        const Move move = from_algebraic_notation(board, san).value();
+        const std::string written = to_algebraic_notation(move, board, legal_moves, suffix);
+        if (written != expected) {
+            throw std::runtime_error("[san_suffix_modes] Expected " + expected + ", got " + written);
+        }
+    };
+    expect("Ra8", SanSuffix::None, "Ra8");
+    expect("Ra8", SanSuffix::Check, "Ra8#");
+    expect("Ra8", SanSuffix::Full, "Ra8# 1-0");
+    expect("Ra7", SanSuffix::Check, "Ra7");
+    expect("Re1", SanSuffix::Full, "Re1");
+}
+
+inline void run_algebraic_notation_tests() {
+    san_round_trip_test();
+    san_parser_forms_test();
+    san_suffix_modes_test();
+}
+
+} // namespace tests
+
+#endif // TESTS_ALGEBRAIC_NOTATION_H
@@ -5,10 +5,12 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <thread>
 #include "../board.h"
 #include "../game.h"
 #include "../lawyer.h"
 #include "../dfs.h"
+#include "../background_search.h"
 #include "../algebraic_notation.h"
 
 namespace tests {
@@ -30,16 +32,11 @@ inline Move make_move(Game& game, const std::string& notation) {
     return move;
 }
 
-inline void run_scenario(const std::string& test_name,
-                         const std::vector<std::string>& moves,
-                         const std::set<std::string>& expected_best,
-                         Oracle oracle,
-                         int max_depth) {
-    Game game;
-    for (const auto& san : moves) {
-        make_move(game, san);
-    }
-
+inline void check_best_move(const std::string& test_name,
+                            const Game& game,
+                            const std::set<std::string>& expected_best,
+                            Oracle oracle,
+                            int max_depth) {
     int orig_max_depth = DFS::MAX_DEPTH;
     DFS::MAX_DEPTH = max_depth;
     const bool white_to_move = game.board().is_white_to_move();
@@ -56,6 +53,28 @@ inline void run_scenario(const std::string& test_name,
     DFS::MAX_DEPTH = orig_max_depth;
 }
 
+inline void run_scenario(const std::string& test_name,
+                         const std::vector<std::string>& moves,
+                         const std::set<std::string>& expected_best,
+                         Oracle oracle,
+                         int max_depth) {
+    Game game;
+    for (const auto& san : moves) {
+        make_move(game, san);
+    }
+    check_best_move(test_name, game, expected_best, std::move(oracle), max_depth);
+}
+
+inline void run_fen_scenario(const std::string& test_name,
+                             const std::string& fen,
+                             const std::set<std::string>& expected_best,
+                             Oracle oracle,
+                             int max_depth) {
+    Game game;
+    game.load_fen(fen);
+    check_best_move(test_name, game, expected_best, std::move(oracle), max_depth);
+}
+
 inline void dfs_e4_e5_material_oracle_test() {
     run_scenario("dfs_e4_e5_material_depth",
                 {"e4", "d5"},
@@ -120,11 +139,120 @@ inline void dfs_lose_bishop_test() {
     }
 }
 
+inline void dfs_back_rank_mate_test() {
+    for (int depth = 1; depth <= 2; ++depth) {
+        run_fen_scenario("dfs_back_rank_mate_depth_" + std::to_string(depth),
+                         "6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1",
+                         {"Ra8# 1-0"},
+                         make_material_oracle(),
+                         depth);
+    }
+}
+
+// Iterative deepening on a worker thread ends on the same move as a plain search, and can be cancelled.
+inline void dfs_background_search_test() {
+    const int orig_max_depth = DFS::MAX_DEPTH;
+    DFS::MAX_DEPTH = 2;
+    Game game;
+    game.load_fen("r1bqkbnr/pppp1ppp/2n5/4p3/2B1P3/5Q2/PPPP1PPP/RNB1K1NR w KQkq - 2 3");
+    DFS plain(make_material_oracle(), true);
+    const Move expected = plain.explore(game.board(), game.get_halfmove_clock());
+
+    DFS agent(make_material_oracle(), true);
+    {
+        BackgroundSearch search(agent, game.board(), game.get_halfmove_clock());
+        while (!search.done()) std::this_thread::yield();
+        const Move found = search.take();
+        if (!(found == expected)) throw std::runtime_error("[dfs_background_search] Iterative deepening changed the move");
+        if (search.depth() != 2 || search.nodes() == 0) {
+            throw std::runtime_error("[dfs_background_search] Progress was not reported");
+        }
+    }
+
+    DFS::MAX_DEPTH = 6;  // far too deep to finish
+    {
+        BackgroundSearch search(agent, game.board(), game.get_halfmove_clock());
+        while (search.nodes() == 0) std::this_thread::yield();
+        search.cancel();
+        try {
+            search.take();  // stopped before depth 1 or with the move of a finished iteration
+        } catch (const std::runtime_error&) {
+        }
+        if (search.depth() >= 6) throw std::runtime_error("[dfs_background_search] Search was not cancelled");
+    }
+    DFS::MAX_DEPTH = orig_max_depth;
+}
+
+// The expected reply is a legal move in the position after the chosen move.
+inline void dfs_ponder_move_test() {
+    const int orig_max_depth = DFS::MAX_DEPTH;
+    Game game;
+    game.load_fen("6k1/5ppp/8/8/8/8/5PPP/R5K1 b - - 0 1");
+    DFS agent(make_material_oracle(), false);
+    DFS::MAX_DEPTH = 1;
+    agent.explore(game.board(), game.get_halfmove_clock());
+    if (agent.ponder_move().has_value()) throw std::runtime_error("[dfs_ponder_move] Depth 1 cannot expect a reply");
+    DFS::MAX_DEPTH = 2;
+    const Move move = agent.explore(game.board(), game.get_halfmove_clock());
+    DFS::MAX_DEPTH = orig_max_depth;
+    if (!agent.ponder_move().has_value()) throw std::runtime_error("[dfs_ponder_move] No expected reply at depth 2");
+    Board after = game.board();
+    Lawyer::instance().perform_legal_move(after, move);
+    if (!Lawyer::instance().legal(after, agent.ponder_move().value())) {
+        throw std::runtime_error("[dfs_ponder_move] Expected reply is not legal");
+    }
+    // Black must not allow Ra8#, so the expected reply is never the mate
+    if (to_algebraic_notation(agent.ponder_move().value(), after) == "Ra8#") {
+        throw std::runtime_error("[dfs_ponder_move] Search expects to be mated");
+    }
+}
+
+// A controlled search reports every iteration, deepest last, ending on the move it returns.
+inline void dfs_iteration_report_test() {
+    Game game;
+    game.load_fen("6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1");
+    DFS agent(make_material_oracle(), true);
+    agent.set_max_depth(3);
+    std::vector<Iteration> iterations;
+    SearchControl control;
+    control.on_iteration = [&](const Iteration& iteration) { iterations.push_back(iteration); };
+    const Move move = agent.explore(game.board(), game.get_halfmove_clock(), control);
+    if (iterations.size() != 3) throw std::runtime_error("[dfs_iteration_report] Expected 3 iterations");
+    for (size_t i = 0; i < iterations.size(); ++i) {
+        if (iterations[i].depth != (int) i + 1 || iterations[i].pv.empty() || iterations[i].nodes == 0) {
+            throw std::runtime_error("[dfs_iteration_report] Malformed iteration " + std::to_string(i + 1));
+        }
+    }
+    if (!(iterations.back().pv.front() == move)) throw std::runtime_error("[dfs_iteration_report] PV does not start with the move");
+    if (iterations.back().score != std::numeric_limits<double>::infinity()) {
+        throw std::runtime_error("[dfs_iteration_report] Ra8# is not scored as a win");
+    }
+}
+
+// A deadline cuts iterative deepening short but still answers with a finished iteration.
+inline void dfs_deadline_test() {
+    Game game;
+    DFS agent(make_material_oracle(), true);
+    agent.set_max_depth(6);  // far too deep to finish
+    SearchControl control;
+    control.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    const Move move = agent.explore(game.board(), game.get_halfmove_clock(), control);
+    if (!Lawyer::instance().legal(game.board(), move)) throw std::runtime_error("[dfs_deadline] Illegal move");
+    if (control.depth < 1 || control.depth >= 6 || !control.stop) {
+        throw std::runtime_error("[dfs_deadline] Deadline did not stop the search");
+    }
+}
+
 inline void run_all() {
     dfs_e4_e5_material_oracle_test();
     dfs_fools_mate_test();
     dfs_scholars_mate_test();
     dfs_lose_bishop_test();
+    dfs_back_rank_mate_test();
+    dfs_background_search_test();
+    dfs_ponder_move_test();
+    dfs_iteration_report_test();
+    dfs_deadline_test();
 }
 
 } // namespace tests
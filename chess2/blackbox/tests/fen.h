@@ -0,0 +1,81 @@
+#ifndef TESTS_FEN_H
+#define TESTS_FEN_H
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../board.h"
+#include "../fen.h"
+#include "../game.h"
+#include "dfs.h"
+
+namespace tests {
+
+inline void fen_round_trip_test() {
+    const std::vector<std::pair<std::vector<std::string>, std::string>> cases = {
+        {{}, fen::STARTING_POSITION},
+        {{"e4"}, "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1"},
+        {{"e4", "c5", "Nf3"}, "rnbqkbnr/pp1ppppp/8/2p5/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2"},
+        {{"e4", "e5", "Ke2"}, "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPPKPPP/RNBQ1BNR b kq - 1 2"},
+    };
+    for (const auto& [moves, expected] : cases) {
+        Game played;
+        for (const auto& san : moves) make_move(played, san);
+        if (played.fen() != expected) {
+            throw std::runtime_error("[fen_round_trip] Expected " + expected + " but got " + played.fen());
+        }
+        Game loaded;
+        loaded.load_fen(expected);
+        if (!(loaded.board() == played.board()) || loaded.board().get_hash() != played.board().get_hash()) {
+            throw std::runtime_error("[fen_round_trip] Loading " + expected + " gives a different board");
+        }
+        if (loaded.fen() != expected) {
+            throw std::runtime_error("[fen_round_trip] Re-exporting " + expected + " gives " + loaded.fen());
+        }
+    }
+}
+
+inline void fen_rejects_invalid_test() {
+    const std::vector<std::string> invalid = {
+        "",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -",             // missing counters
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 x",       // extra field
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR  w KQkq - 0 1",        // double space
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1",                  // 7 ranks
+        "rnbqkbnr/pppppppp/44/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",        // consecutive digits
+        "rnbqkbnr/ppppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",        // 9 squares
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQ1BNR w kq - 0 1",           // no white king
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1",         // bad side
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w QK - 0 1",           // castling order
+        "rnbqkbn1/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",         // k right without rook
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e6 0 1",        // no pawn to capture
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - -1 1",        // negative clock
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 0",         // fullmove 0
+        "Pnbqkbnr/pppppppp/8/8/8/8/1PPPPPPP/RNBQKBNR w KQkq - 0 1",         // pawn on back rank
+        "4k2R/8/8/8/8/8/8/4K3 w - - 0 1",                                   // black in check, white to move
+    };
+    for (const auto& text : invalid) {
+        Board board;
+        int halfmove = 0, fullmove = 0;
+        bool threw = false;
+        try {
+            fen::parse(text, board, halfmove, fullmove);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        if (!threw) throw std::runtime_error("[fen_rejects_invalid] Accepted invalid FEN: " + text);
+    }
+    // The same position is fine with black to move
+    Board board;
+    int halfmove = 0, fullmove = 0;
+    fen::parse("4k2R/8/8/8/8/8/8/4K3 b - - 0 1", board, halfmove, fullmove);
+}
+
+inline void run_fen_tests() {
+    fen_round_trip_test();
+    fen_rejects_invalid_test();
+}
+
+} // namespace tests
+
+#endif // TESTS_FEN_H
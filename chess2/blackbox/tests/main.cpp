@@ -1,8 +1,28 @@
 #include <iostream>
 #include "dfs.h"
+#include "nnue.h"
+#include "oracle.h"
+#include "pawn_structure.h"
+#include "fen.h"
+#include "algebraic_notation.h"
+#include "pgn.h"
+#include "opening_book.h"
+#include "tablebase.h"
+#include "uci.h"
+#include "match.h"
 
 int main() {
     try {
+        tests::run_nnue_tests();
+        tests::run_oracle_tests();
+        tests::run_pawn_structure_tests();
+        tests::run_fen_tests();
+        tests::run_algebraic_notation_tests();
+        tests::run_pgn_tests();
+        tests::run_opening_book_tests();
+        tests::run_tablebase_tests();
+        tests::run_uci_tests();
+        tests::run_match_tests();
         tests::run_all();
         std::cout << "All tests passed\n";
         return 0;
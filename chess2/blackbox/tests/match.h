@@ -0,0 +1,62 @@
+#ifndef TESTS_MATCH_H
+#define TESTS_MATCH_H
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include "../match.h"
+
+namespace tests {
+
+inline void match_sprt_test() {
+    match::SprtOptions sprt;
+    sprt.elo0 = 0;
+    sprt.elo1 = 10;
+    if (std::abs(sprt.upper_bound() - std::log(19.0)) > 1e-9 || std::abs(sprt.lower_bound() + std::log(19.0)) > 1e-9) {
+        throw std::runtime_error("[match_sprt] Wrong bounds for alpha = beta = 0.05");
+    }
+    const match::Score even{300, 400, 300};
+    const match::Score strong{450, 400, 150};
+    if (match::sprt_llr(even, sprt.elo0, sprt.elo1) >= 0) throw std::runtime_error("[match_sprt] Even score favours H1");
+    if (match::sprt_llr(strong, sprt.elo0, sprt.elo1) < sprt.upper_bound()) {
+        throw std::runtime_error("[match_sprt] +105 elo over 1000 games does not accept H1");
+    }
+    const auto [elo, margin] = match::elo_estimate(strong);
+    if (std::abs(elo - 107.5) > 1.0 || margin <= 0 || margin > 30) {
+        throw std::runtime_error("[match_sprt] Elo estimate " + std::to_string(elo) + " +/- " + std::to_string(margin));
+    }
+}
+
+inline void match_run_test() {
+    const match::EngineConfig a = match::parse_engine("a:depth=1");
+    const match::EngineConfig b = match::parse_engine("b:eval=structural,depth=2");
+    if (a.depth != 1 || b.evaluation != "structural" || b.name != "b") {
+        throw std::runtime_error("[match_run] Engine specs misparsed");
+    }
+    const match::TimeControl tc = match::parse_time_control("0.5+0.01");
+    if (tc.base_ms != 500 || tc.increment_ms != 10) throw std::runtime_error("[match_run] Time control misparsed");
+
+    match::MatchOptions options;
+    options.games = 4;
+    options.threads = 2;
+    options.max_plies = 40;
+    options.openings = {"6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1"};
+    const match::MatchResult fixed = match::run(a, b, options);
+    if (fixed.score.games() != 4) throw std::runtime_error("[match_run] Not every game was counted");
+
+    options.games = 2;
+    options.time_control = tc;
+    const match::MatchResult timed = match::run(a, b, options);
+    if (timed.score.games() != 2) throw std::runtime_error("[match_run] Not every timed game was counted");
+    // Whoever has White mates on the back rank at once
+    if (timed.score.wins != 1 || timed.score.losses != 1) throw std::runtime_error("[match_run] Missed Ra8#");
+}
+
+inline void run_match_tests() {
+    match_sprt_test();
+    match_run_test();
+}
+
+} // namespace tests
+
+#endif // TESTS_MATCH_H
@@ -0,0 +1,129 @@
+#ifndef TESTS_NNUE_H
+#define TESTS_NNUE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../board.h"
+#include "../lawyer.h"
+#include "../nnue.h"
+#include "../oracle.h"
+#include "../algebraic_notation.h"
+
+namespace tests {
+
+// Deterministic small random weights, so the accumulator never overflows int16.
+inline std::shared_ptr<nnue::Network> make_random_network(uint32_t seed) {
+    auto net = std::make_shared<nnue::Network>();
+    auto next = [&seed](int lo, int hi) {
+        seed = seed * 1664525u + 1013904223u;
+        return lo + static_cast<int>((seed >> 8) % static_cast<uint32_t>(hi - lo + 1));
+    };
+    for (auto& w : net->ft_weights) w = static_cast<int16_t>(next(-64, 63));
+    for (auto& b : net->ft_biases) b = static_cast<int16_t>(next(-64, 63));
+    for (auto& w : net->l1_weights) w = static_cast<int8_t>(next(-64, 63));
+    for (auto& b : net->l1_biases) b = next(-2000, 2000);
+    for (auto& w : net->l2_weights) w = static_cast<int8_t>(next(-64, 63));
+    for (auto& b : net->l2_biases) b = next(-2000, 2000);
+    for (auto& w : net->out_weights) w = static_cast<int8_t>(next(-64, 63));
+    net->out_bias = next(-2000, 2000);
+    return net;
+}
+
+// Plain scalar forward pass straight from the piece list, independent of the kernels.
+inline int reference_nnue_eval(const nnue::Network& net, const Board& board) {
+    int acc[2][nnue::HIDDEN];
+    for (int p = 0; p < 2; ++p) {
+        for (int i = 0; i < nnue::HIDDEN; ++i) acc[p][i] = net.ft_biases[i];
+        for (int idx = 0; idx < board.get_piece_count(); ++idx) {
+            const Piece& piece = board.get_piece(idx);
+            const int f = nnue::feature_index(p == 0, piece.kind, piece.white, piece.x, piece.y);
+            for (int i = 0; i < nnue::HIDDEN; ++i) acc[p][i] += net.ft_weights[f * nnue::HIDDEN + i];
+        }
+    }
+    auto clip = [](int v) { return v < 0 ? 0 : (v > nnue::CLIP_MAX ? nnue::CLIP_MAX : v); };
+    const int us = board.is_white_to_move() ? 0 : 1;
+    int input[2 * nnue::HIDDEN];
+    for (int i = 0; i < nnue::HIDDEN; ++i) {
+        input[i] = clip(acc[us][i]);
+        input[nnue::HIDDEN + i] = clip(acc[1 - us][i]);
+    }
+    int h1[nnue::L1];
+    for (int o = 0; o < nnue::L1; ++o) {
+        int sum = net.l1_biases[o];
+        for (int i = 0; i < 2 * nnue::HIDDEN; ++i) sum += net.l1_weights[o * 2 * nnue::HIDDEN + i] * input[i];
+        h1[o] = clip(sum >> nnue::WEIGHT_SHIFT);
+    }
+    int h2[nnue::L2];
+    for (int o = 0; o < nnue::L2; ++o) {
+        int sum = net.l2_biases[o];
+        for (int i = 0; i < nnue::L1; ++i) sum += net.l2_weights[o * nnue::L1 + i] * h1[i];
+        h2[o] = clip(sum >> nnue::WEIGHT_SHIFT);
+    }
+    int out = net.out_bias;
+    for (int i = 0; i < nnue::L2; ++i) out += net.out_weights[i] * h2[i];
+    return out / nnue::OUTPUT_SCALE;
+}
+
+inline void nnue_incremental_matches_refresh_test() {
+    auto net = make_random_network(12345);
+    Board board;
+    board.reset();
+    board.attach_accumulator(*net);
+
+    // Covers en passant, capture-promotion and both sides castling.
+    const std::vector<std::string> moves = {
+        "e4", "d5", "exd5", "c5", "dxc6", "Nf6", "cxb7", "Nbd7", "bxa8=Q",
+        "e6", "Nf3", "Bc5", "Be2", "O-O", "O-O"
+    };
+    Lawyer& lawyer = Lawyer::instance();
+    for (const auto& san : moves) {
+        auto move = from_algebraic_notation(board, san);
+        if (!move.has_value()) throw std::runtime_error("[nnue_incremental] Failed to parse move " + san);
+        lawyer.perform_move(board, move.value());
+
+        Board fresh(board);
+        fresh.attach_accumulator(*net);
+        for (int p = 0; p < 2; ++p) {
+            for (int i = 0; i < nnue::HIDDEN; ++i) {
+                if (board.get_accumulator().values[p][i] != fresh.get_accumulator().values[p][i]) {
+                    throw std::runtime_error("[nnue_incremental] Accumulator drifted after " + san);
+                }
+            }
+        }
+        const int incremental = nnue::evaluate(board.get_accumulator(), board.is_white_to_move());
+        const int reference = reference_nnue_eval(*net, board);
+        if (incremental != reference) {
+            throw std::runtime_error("[nnue_incremental] Evaluation after " + san + " is " +
+                                     std::to_string(incremental) + ", expected " + std::to_string(reference));
+        }
+    }
+}
+
+inline void nnue_load_save_test() {
+    auto net = make_random_network(777);
+    const std::string path = "nnue_test_weights.bin";
+    net->save(path);
+    auto loaded = nnue::Network::load(path);
+    std::remove(path.c_str());
+
+    Board board;
+    board.reset();
+    Oracle saved_oracle = make_nnue_oracle(net);
+    Oracle loaded_oracle = make_nnue_oracle(loaded);
+    if (saved_oracle.evaluate(board) != loaded_oracle.evaluate(board)) {
+        throw std::runtime_error("[nnue_load_save] Loaded network evaluates differently");
+    }
+}
+
+inline void run_nnue_tests() {
+    nnue_incremental_matches_refresh_test();
+    nnue_load_save_test();
+}
+
+} // namespace tests
+
+#endif // TESTS_NNUE_H
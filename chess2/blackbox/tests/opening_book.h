@@ -0,0 +1,107 @@
+#ifndef TESTS_OPENING_BOOK_H
+#define TESTS_OPENING_BOOK_H
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../algebraic_notation.h"
+#include "../book_builder.h"
+#include "../dfs.h"
+#include "../opening_book.h"
+#include "pawn_structure.h"
+
+namespace tests {
+
+inline book::Entry book_entry(const Board& board, const std::string& san, uint16_t weight) {
+    const Move move = from_algebraic_notation(board, san).value();
+    return book::Entry{board.get_hash(), book::encode_move(move), weight, 1};
+}
+
+inline void opening_book_probe_test() {
+    const Game start = play_moves({});
+    const Game after_e4 = play_moves({"e4"});
+    const Game promotion = play_moves({"e4", "d5", "exd5", "c6", "dxc6", "Nf6", "cxb7", "Nbd7"});
+    std::vector<book::Entry> entries = {
+        book_entry(after_e4.board(), "c5", 3),
+        book_entry(start.board(), "e4", 1),
+        book_entry(after_e4.board(), "e5", 0),  // known, never chosen
+        book_entry(promotion.board(), "bxa8=N", 5),
+        book_entry(start.board(), "d4", 1),
+    };
+    const std::string path = "opening_book_test.bin";
+    book::write(path, entries);
+    auto opened = book::OpeningBook::open(path);
+    std::remove(path.c_str());  // the mapping stays valid
+
+    if (opened->size() != entries.size()) throw std::runtime_error("[opening_book] Wrong entry count");
+    auto expect = [&](const Board& board, uint64_t random, const std::string& expected) {
+        const auto move = opened->probe(board, random);
+        const std::string got = move.has_value() ? to_algebraic_notation(move.value(), board, SanSuffix::None) : "none";
+        if (got != expected) {
+            throw std::runtime_error("[opening_book] Expected " + expected + ", got " + got);
+        }
+    };
+    expect(start.board(), 0, "d4");  // sorted by move code, d2d4 before e2e4
+    expect(start.board(), 1, "e4");
+    expect(after_e4.board(), 2, "c5");
+    expect(promotion.board(), 7, "bxa8=N");
+    expect(play_moves({"d4"}).board(), 0, "none");
+
+    // The book answers before any search
+    DFS agent(make_material_oracle(), false);
+    agent.set_book(opened, 42);
+    const Move reply = agent.explore(after_e4.board());
+    if (to_algebraic_notation(reply, after_e4.board(), SanSuffix::None) != "c5") {
+        throw std::runtime_error("[opening_book] DFS did not play the book move");
+    }
+}
+
+inline void book_builder_test() {
+    const std::string pgn_path = "book_builder_test.pgn";
+    const std::string book_path = "book_builder_test.bin";
+    {
+        std::ofstream pgn_file(pgn_path);
+        pgn_file << "[Result \"1-0\"]\n\n1. e4 e5 2. Nf3 1-0\n\n"
+                    "[Result \"1/2-1/2\"]\n\n1. e4 e5 2. Bc4 1/2-1/2\n\n"
+                    "[Result \"0-1\"]\n\n1. d4 d5 0-1\n\n"
+                    "[Result \"*\"]\n\n1. c4 *\n\n"
+                    "[Result \"1-0\"]\n\n1. e4 Ke7 1-0\n\n";  // illegal
+    }
+    book::BuildOptions options;
+    options.threads = 2;
+    options.batch_games = 1;
+    options.memory_bytes = 0;  // a run per batch at least
+    const book::BuildStats stats = book::build({pgn_path}, book_path, options);
+    std::remove(pgn_path.c_str());
+    auto opened = book::OpeningBook::open(book_path);
+    std::remove(book_path.c_str());
+
+    if (stats.games != 3 || stats.skipped_games != 2 || stats.entries != 6) {
+        throw std::runtime_error("[book_builder] Unexpected stats: " + std::to_string(stats.games) + " games, " +
+                                 std::to_string(stats.skipped_games) + " skipped, " + std::to_string(stats.entries) + " entries");
+    }
+    const Game start = play_moves({});
+    const auto [first, last] = opened->find(start.board().get_hash());
+    if (last - first != 2) throw std::runtime_error("[book_builder] Expected two moves from the start");
+    for (const book::Entry* e = first; e != last; ++e) {
+        const std::string san = to_algebraic_notation(book::decode_move(e->move, start.board()).value(), start.board(), SanSuffix::None);
+        const bool ok = (san == "e4" && e->games == 2 && e->weight == 3) || (san == "d4" && e->games == 1 && e->weight == 0);
+        if (!ok) throw std::runtime_error("[book_builder] Wrong entry for " + san);
+    }
+    const Game after_e4 = play_moves({"e4"});
+    const auto e5 = opened->find(after_e4.board().get_hash());
+    if (e5.second - e5.first != 1 || e5.first->games != 2 || e5.first->weight != 1) {
+        throw std::runtime_error("[book_builder] Wrong entry for e5");
+    }
+}
+
+inline void run_opening_book_tests() {
+    opening_book_probe_test();
+    book_builder_test();
+}
+
+} // namespace tests
+
+#endif // TESTS_OPENING_BOOK_H
@@ -0,0 +1,73 @@
+#ifndef TESTS_ORACLE_H
+#define TESTS_ORACLE_H
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../board.h"
+#include "../fen.h"
+#include "../lawyer.h"
+#include "../move.h"
+#include "../oracle.h"
+#include "nnue.h"
+
+namespace tests {
+
+// Leaves as DFS hands them over: the children of a few positions, prepared by `oracle` at the
+// root, plus the roots themselves parsed fresh (no accumulator)
+inline std::vector<Board> oracle_test_boards(const Oracle& oracle) {
+    const std::vector<std::string> fens = {
+        fen::STARTING_POSITION,
+        "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+        "r3k2r/pPp2ppp/8/3pP3/8/8/2P2PPP/R3K2R w KQkq d6 0 1",
+        "8/5k2/3p4/2pP4/2P5/4K3/8/8 b - - 0 1",
+    };
+    Lawyer& lawyer = Lawyer::instance();
+    std::vector<Board> boards;
+    for (const std::string& position : fens) {
+        Board root;
+        int halfmove_clock = 0;
+        int fullmove_number = 1;
+        fen::parse(position, root, halfmove_clock, fullmove_number);
+        boards.push_back(root);
+        oracle.prepare(root);
+        for (const Move& move : lawyer.legal_moves(root)) {
+            Board child = root;
+            lawyer.perform_legal_move(child, move);
+            boards.push_back(std::move(child));
+        }
+    }
+    return boards;
+}
+
+// evaluate_batch() scores every board exactly as evaluate() does, batch after batch
+inline void oracle_batch_matches_evaluate_test(const std::string& name, const Oracle& oracle) {
+    const std::vector<Board> boards = oracle_test_boards(oracle);
+    std::vector<const Board*> pointers;
+    for (const Board& board : boards) pointers.push_back(&board);
+    std::vector<double> scores(boards.size());
+    for (int pass = 0; pass < 2; ++pass) {  // the second pass finds the pawn hash table filled
+        oracle.evaluate_batch(pointers.data(), scores.data(), pointers.size());
+        for (size_t i = 0; i < boards.size(); ++i) {
+            const double expected = oracle.evaluate(boards[i]);
+            if (scores[i] != expected) {
+                throw std::runtime_error("[oracle_batch_" + name + "] Board " + std::to_string(i) + " scored " +
+                                         std::to_string(scores[i]) + " in a batch, " + std::to_string(expected) + " alone");
+            }
+        }
+    }
+    double untouched = 42.0;
+    oracle.evaluate_batch(pointers.data(), &untouched, 0);
+    if (untouched != 42.0) throw std::runtime_error("[oracle_batch_" + name + "] Empty batch wrote a score");
+}
+
+inline void run_oracle_tests() {
+    oracle_batch_matches_evaluate_test("basic", Oracle{});
+    oracle_batch_matches_evaluate_test("material", make_material_oracle());
+    oracle_batch_matches_evaluate_test("structural", make_structural_oracle(8));
+    oracle_batch_matches_evaluate_test("nnue", make_nnue_oracle(make_random_network(2024)));
+}
+
+} // namespace tests
+
+#endif // TESTS_ORACLE_H
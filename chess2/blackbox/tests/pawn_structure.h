@@ -0,0 +1,64 @@
+#ifndef TESTS_PAWN_STRUCTURE_H
+#define TESTS_PAWN_STRUCTURE_H
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../board.h"
+#include "../game.h"
+#include "../pawn_structure.h"
+#include "dfs.h"
+
+namespace tests {
+
+inline Game play_moves(const std::vector<std::string>& moves) {
+    Game game;
+    for (const auto& san : moves) make_move(game, san);
+    return game;
+}
+
+inline void zobrist_transposition_test() {
+    const Game a = play_moves({"Nf3", "Nf6", "Nc3", "Nc6"});
+    const Game b = play_moves({"Nc3", "Nc6", "Nf3", "Nf6"});
+    if (a.board().get_hash() != b.board().get_hash()) {
+        throw std::runtime_error("[zobrist_transposition] Transposed positions hash differently");
+    }
+    Board start;
+    start.reset();
+    if (a.board().get_hash() == start.get_hash()) {
+        throw std::runtime_error("[zobrist_transposition] Different positions hash equally");
+    }
+    if (a.board().get_pawn_key() != start.get_pawn_key()) {
+        throw std::runtime_error("[zobrist_transposition] Knight moves changed the pawn key");
+    }
+}
+
+inline void pawn_structure_doubled_pawn_test() {
+    pawn_structure::PawnHashTable table(8);
+    const Game doubled = play_moves({"e4", "d5", "exd5"});
+    if (table.probe(doubled.board()).score != -pawn_structure::DOUBLED_PENALTY) {
+        throw std::runtime_error("[pawn_structure_doubled] Expected a doubled pawn penalty, got " +
+                                 std::to_string(table.probe(doubled.board()).score));
+    }
+    // Same pawns, different pieces: served from the table
+    const Game developed = play_moves({"e4", "d5", "exd5", "Nf6"});
+    if (table.probe(developed.board()).score != -pawn_structure::DOUBLED_PENALTY) {
+        throw std::runtime_error("[pawn_structure_doubled] Cached entry has the wrong score");
+    }
+    const Game recaptured = play_moves({"e4", "d5", "exd5", "Qxd5", "Nc3"});
+    if (table.probe(recaptured.board()).score != 0) {
+        throw std::runtime_error("[pawn_structure_doubled] Expected an even pawn structure");
+    }
+    if (table.hits() != 1 || table.misses() != 2) {
+        throw std::runtime_error("[pawn_structure_doubled] Unexpected pawn hash hit/miss counts");
+    }
+}
+
+inline void run_pawn_structure_tests() {
+    zobrist_transposition_test();
+    pawn_structure_doubled_pawn_test();
+}
+
+} // namespace tests
+
+#endif // TESTS_PAWN_STRUCTURE_H
@@ -0,0 +1,143 @@
+#ifndef TESTS_PGN_H
+#define TESTS_PGN_H
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "../game.h"
+#include "../pgn.h"
+#include "pawn_structure.h"
+
+namespace tests {
+
+inline void pgn_reader_test() {
+    std::istringstream archive(
+        "% exported by hand\n"
+        "[Event \"Casual \\\"blitz\\\"\"]\n"
+        "[Result \"1-0\"]\n"
+        "\n"
+        "1. e4 {best by test} e5 2.Nf3 (2. f4 exf4 (2... d5) 3. Nf3) 2...Nc6 $1\n"
+        "3. Bb5 ; the Spanish\n"
+        "a6 4. Ba4 1-0\n"
+        "\n"
+        "[Event \"Broken\"]\n"
+        "\n"
+        "1. e4 ) e5 *\n"
+        "\n"
+        "[Event \"From a position\"]\n"
+        "[SetUp \"1\"]\n"
+        "[FEN \"6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1\"]\n"
+        "\n"
+        "1. Ra8# 1-0\n");
+    pgn::ReaderOptions options;
+    options.keep_comments = true;
+    options.keep_variations = true;
+    pgn::Reader reader(archive, options);
+    pgn::GameRecord record;
+
+    if (!reader.next(record)) throw std::runtime_error("[pgn_reader] First game missing");
+    if (record.tag("Event") == nullptr || *record.tag("Event") != "Casual \"blitz\"") {
+        throw std::runtime_error("[pgn_reader] Escaped tag value read wrong");
+    }
+    if (record.moves.size() != 7 || record.moves[2] != "Nf3" || record.moves[3] != "Nc6" || record.result != "1-0") {
+        throw std::runtime_error("[pgn_reader] Main line read wrong");
+    }
+    if (record.annotations.size() != 3 || !record.annotations[1].variation || record.annotations[1].ply != 3 ||
+        record.annotations[1].text != "2. f4 exf4 (2... d5) 3. Nf3" || record.annotations[2].text != " the Spanish") {
+        throw std::runtime_error("[pgn_reader] Comments or variations read wrong");
+    }
+    Game game;
+    pgn::replay(record, game);
+    if (game.fen() != "r1bqkbnr/1ppp1ppp/p1n5/4p3/B3P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 1 4") {
+        throw std::runtime_error("[pgn_reader] Replay reached " + game.fen());
+    }
+
+    bool threw = false;
+    try {
+        reader.next(record);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    if (!threw) throw std::runtime_error("[pgn_reader] Malformed game accepted");
+
+    if (!reader.next(record)) throw std::runtime_error("[pgn_reader] Reader did not recover after an error");
+    pgn::replay(record, game);
+    if (game.winner() != GameWinner::White) throw std::runtime_error("[pgn_reader] Game from FEN not replayed");
+    if (reader.next(record)) throw std::runtime_error("[pgn_reader] Phantom game at the end");
+}
+
+// A game missing its result runs into the next game's tags: that game is an error, the next one is read whole
+inline void pgn_missing_result_test() {
+    std::istringstream archive(
+        "[Event \"A\"]\n"
+        "\n"
+        "1. e4 e5\n"
+        "\n"
+        "[Event \"B\"]\n"
+        "\n"
+        "1. d4 d5 1-0\n"
+        "\n"
+        "[Event \"C\"]\n"
+        "\n"
+        "1. c4 e5 *\n");
+    pgn::Reader reader(archive);
+    pgn::GameRecord record;
+
+    bool threw = false;
+    try {
+        reader.next(record);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    if (!threw) throw std::runtime_error("[pgn_missing_result] Game without a result accepted");
+    for (const char* event : {"B", "C"}) {
+        if (!reader.next(record) || record.tag("Event") == nullptr || *record.tag("Event") != event) {
+            throw std::runtime_error(std::string("[pgn_missing_result] Game ") + event + " lost");
+        }
+        if (record.moves.size() != 2) throw std::runtime_error(std::string("[pgn_missing_result] Game ") + event + " read wrong");
+    }
+    if (reader.next(record)) throw std::runtime_error("[pgn_missing_result] Phantom game at the end");
+}
+
+inline void pgn_round_trip_test() {
+    // Long enough to wrap, with castling, en passant and a promotion
+    const Game game = play_moves({
+        "e4", "d5", "e5", "f5", "exf6", "Nc6", "fxg7", "Bf5", "gxh8=Q", "Qd7",
+        "Nf3", "O-O-O", "Bb5", "a6", "O-O", "axb5", "Qxg8", "Kb8"
+    });
+    pgn::GameRecord record = pgn::record_of(game, {{"Event", "Round trip"}});
+    record.annotations.push_back(pgn::Annotation{1, false, "a comment"});
+    std::string text;
+    pgn::write(record, text);
+
+    std::istringstream in(text);
+    pgn::ReaderOptions options;
+    options.keep_comments = true;
+    pgn::Reader reader(in, options);
+    pgn::GameRecord read_back;
+    if (!reader.next(read_back) || read_back.moves != record.moves || read_back.annotations.size() != 1) {
+        throw std::runtime_error("[pgn_round_trip] Written game did not read back:\n" + text);
+    }
+    Game replayed;
+    pgn::replay(read_back, replayed);
+    if (replayed.fen() != game.fen()) {
+        throw std::runtime_error("[pgn_round_trip] Replayed game reached " + replayed.fen());
+    }
+
+    int positions = 0;
+    Board scratch;
+    pgn::for_each_position(read_back, scratch, [&](const Board&, const Move&) { ++positions; });
+    if (positions != static_cast<int>(game.moves().size()) || scratch.get_hash() != game.board().get_hash()) {
+        throw std::runtime_error("[pgn_round_trip] for_each_position walked the wrong line");
+    }
+}
+
+inline void run_pgn_tests() {
+    pgn_reader_test();
+    pgn_missing_result_test();
+    pgn_round_trip_test();
+}
+
+} // namespace tests
+
+#endif // TESTS_PGN_H
@@ -0,0 +1,126 @@
+#ifndef TESTS_TABLEBASE_H
+#define TESTS_TABLEBASE_H
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../dfs.h"
+#include "../fen.h"
+#include "../game.h"
+#include "../tablebase.h"
+#include "../tablebase_generator.h"
+
+namespace tests {
+
+inline uint16_t probe_fen(const tablebase::Generator& generator, const std::string& position) {
+    int halfmove_clock = 0;
+    int fullmove_number = 1;
+    return generator.probe(fen::parse(position, halfmove_clock, fullmove_number));
+}
+
+// Probing the mapped files agrees with the generator, and DFS plays the tables' moves.
+inline void tablebase_probe_test(const tablebase::Generator& generator, const std::string& directory) {
+    auto tables = tablebase::Tablebase::open(directory, 2);  // tiny LRU, so pages get released
+    if (tables->max_pieces() != 3 || tables->table_count() != 1) {
+        throw std::runtime_error("[tablebase_probe] Expected one 3-piece table");
+    }
+    const tablebase::Material material = tablebase::parse_material("KQvK");
+    const tablebase::Layout layout(material);
+    Board board;
+    for (uint64_t index = 0; index < layout.size(); index += 97) {
+        if (!layout.decode(index, board) || board.is_player_in_check(!board.is_white_to_move())) continue;
+        if (tables->probe(board) != generator.probe(board)) {
+            throw std::runtime_error("[tablebase_probe] Mapped table disagrees at index " + std::to_string(index));
+        }
+    }
+    int halfmove_clock = 0;
+    int fullmove_number = 1;
+    if (tables->probe(fen::parse("4k3/8/8/8/8/8/8/R3K3 w Q - 0 1", halfmove_clock, fullmove_number)).has_value()) {
+        throw std::runtime_error("[tablebase_probe] Probed a position with castling rights");
+    }
+
+    // Depth 1 cannot see a distant mate, the tables can
+    const int orig_max_depth = DFS::MAX_DEPTH;
+    DFS::MAX_DEPTH = 1;
+    DFS agent(make_material_oracle(), true);
+    agent.set_tablebase(tables);
+    Game game;
+    game.load_fen("8/8/8/3k4/8/8/7Q/K7 w - - 0 1");
+    int plies = tablebase::plies_to_mate(tables->probe(game.board()).value());
+    while (game.status() == GameStatus::Ongoing) {
+        const Move move = game.board().is_white_to_move()
+            ? agent.explore(game.board(), game.get_halfmove_clock())
+            : Lawyer::instance().legal_moves(game.board()).front();
+        if (game.verify_and_move(move) != 0) throw std::runtime_error("[tablebase_probe] Illegal move played");
+        if (game.status() != GameStatus::Ongoing) break;
+        const int remaining = tablebase::plies_to_mate(tables->probe(game.board()).value());
+        if (remaining > plies - 1) throw std::runtime_error("[tablebase_probe] Move did not make progress towards mate");
+        plies = remaining;
+    }
+    DFS::MAX_DEPTH = orig_max_depth;
+    if (game.status() != GameStatus::Checkmate) throw std::runtime_error("[tablebase_probe] Did not mate with KQvK");
+}
+
+inline void tablebase_kqk_test() {
+    const std::string directory = "tablebase_test_tables";
+    std::filesystem::create_directories(directory);
+    {
+        tablebase::Generator generator(2, directory);
+        const std::vector<uint16_t>& codes = generator.generate(tablebase::parse_material("KvKQ"));
+
+        // Longest KQK win is mate in 10
+        int longest = 0;
+        for (size_t index = 0; index < codes.size(); index += 2) {  // white to move
+            if (tablebase::is_win(codes[index])) longest = std::max(longest, tablebase::plies_to_mate(codes[index]));
+        }
+        if (longest != 19) {
+            throw std::runtime_error("[tablebase_kqk] Longest win is " + std::to_string(longest) + " plies, expected 19");
+        }
+        auto expect = [&](const std::string& position, uint16_t expected) {
+            const uint16_t code = probe_fen(generator, position);
+            if (code != expected) {
+                throw std::runtime_error("[tablebase_kqk] " + position + " has code " + std::to_string(code) +
+                                         ", expected " + std::to_string(expected));
+            }
+        };
+        expect("k7/8/1K6/8/8/8/8/6Q1 w - - 0 1", tablebase::code_for_plies(1));
+        expect("6q1/8/8/8/8/1k6/8/K7 b - - 0 1", tablebase::code_for_plies(1));  // colours swapped
+        expect("k7/1Q6/1K6/8/8/8/8/8 b - - 0 1", tablebase::code_for_plies(0));  // mated
+        expect("k7/2Q5/1K6/8/8/8/8/8 b - - 0 1", tablebase::DRAW);               // stalemate
+        expect("k7/1Q6/8/8/8/8/8/6K1 b - - 0 1", tablebase::DRAW);               // queen hangs
+    }
+    // Tables written to disk are loaded back instead of regenerated
+    tablebase::Generator reloaded(1, directory);
+    reloaded.generate(tablebase::parse_material("KQvK"));
+    const uint16_t code = probe_fen(reloaded, "k7/8/1K6/8/8/8/8/6Q1 w - - 0 1");
+    tablebase_probe_test(reloaded, directory);
+    std::filesystem::remove_all(directory);
+    if (code != tablebase::code_for_plies(1)) {
+        throw std::runtime_error("[tablebase_kqk] Reloaded table differs");
+    }
+}
+
+inline void tablebase_dependencies_test() {
+    std::vector<std::string> names;
+    for (const auto& m : tablebase::Generator::dependencies(tablebase::parse_material("KRvKP"))) names.push_back(m.name());
+    const std::vector<std::string> expected = {"KPvK", "KRvK", "KRvKQ", "KRvKR", "KRvKB", "KRvKN"};
+    if (names.size() != expected.size()) {
+        throw std::runtime_error("[tablebase_dependencies] Wrong number of dependencies for KRvKP");
+    }
+    for (const auto& name : expected) {
+        if (std::find(names.begin(), names.end(), name) == names.end() &&
+            std::find(names.begin(), names.end(), tablebase::parse_material(name).flipped().name()) == names.end()) {
+            throw std::runtime_error("[tablebase_dependencies] Missing " + name);
+        }
+    }
+}
+
+inline void run_tablebase_tests() {
+    tablebase_dependencies_test();
+    tablebase_kqk_test();
+}
+
+} // namespace tests
+
+#endif // TESTS_TABLEBASE_H
@@ -0,0 +1,93 @@
+#ifndef TESTS_UCI_H
+#define TESTS_UCI_H
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "../dfs.h"
+#include "../fen.h"
+#include "../game.h"
+#include "../lawyer.h"
+#include "../uci.h"
+
+namespace tests {
+
+inline void uci_move_notation_test() {
+    int halfmove_clock = 0;
+    int fullmove_number = 1;
+    const Board board = fen::parse("r3k2r/1P6/8/8/8/8/8/R3K2R w KQkq - 0 1", halfmove_clock, fullmove_number);
+    for (const char* text : {"e1g1", "e1c1", "b7a8n", "b7b8q", "a1a8"}) {
+        const std::optional<Move> move = uci::parse_move(board, text);
+        if (!move.has_value()) throw std::runtime_error(std::string("[uci_move_notation] Could not parse ") + text);
+        if (uci::move_to_string(move.value()) != text) {
+            throw std::runtime_error(std::string("[uci_move_notation] Round trip changed ") + text);
+        }
+    }
+    if (uci::move_to_string(uci::parse_move(board, "e1g1").value()) != "e1g1" ||
+        !uci::parse_move(board, "e1g1")->is_attempted_castling()) {
+        throw std::runtime_error("[uci_move_notation] e1g1 is not castling");
+    }
+    if (uci::parse_move(board, "b7b8").has_value() || uci::parse_move(board, "e1e3").has_value()) {
+        throw std::runtime_error("[uci_move_notation] Parsed an illegal move");
+    }
+}
+
+// Last "bestmove" of the output, as a legal move of `board`
+inline Move uci_best_move(const std::string& output, const Board& board) {
+    const size_t at = output.rfind("bestmove ");
+    if (at == std::string::npos) throw std::runtime_error("[uci_session] No bestmove in: " + output);
+    std::istringstream in(output.substr(at + 9));
+    std::string text;
+    in >> text;
+    const std::optional<Move> move = uci::parse_move(board, text);
+    if (!move.has_value()) throw std::runtime_error("[uci_session] Illegal bestmove " + text);
+    return move.value();
+}
+
+inline void uci_session_test() {
+    std::ostringstream out;
+    uci::Engine engine(out);
+    engine.execute("uci");
+    engine.execute("isready");
+    if (out.str().find("uciok") == std::string::npos || out.str().find("readyok") == std::string::npos) {
+        throw std::runtime_error("[uci_session] Missing uciok or readyok");
+    }
+
+    engine.execute("position startpos moves e2e4 e7e5 g1f3");
+    Game expected;
+    expected.load_fen("rnbqkbnr/pppp1ppp/8/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2");
+    if (engine.game().board().get_hash() != expected.board().get_hash()) {
+        throw std::runtime_error("[uci_session] position startpos moves reached the wrong board");
+    }
+    engine.execute("go depth 2");
+    engine.wait();
+    uci_best_move(out.str(), engine.game().board());
+    if (out.str().find("info depth 2 ") == std::string::npos) {
+        throw std::runtime_error("[uci_session] No info line for depth 2");
+    }
+
+    // A timed search finds the mate in one
+    engine.execute("position fen 6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1");
+    engine.execute("go wtime 2000 btime 2000");
+    engine.wait();
+    if (uci::move_to_string(uci_best_move(out.str(), engine.game().board())) != "a1a8") {
+        throw std::runtime_error("[uci_session] Timed search missed Ra8#");
+    }
+
+    // An infinite search answers once stopped
+    engine.execute("position startpos");
+    const size_t before = out.str().size();
+    engine.execute("go infinite");
+    engine.execute("stop");
+    uci_best_move(out.str().substr(before), engine.game().board());
+    if (engine.execute("quit")) throw std::runtime_error("[uci_session] quit did not end the session");
+}
+
+inline void run_uci_tests() {
+    uci_move_notation_test();
+    uci_session_test();
+}
+
+} // namespace tests
+
+#endif // TESTS_UCI_H
@@ -0,0 +1,19 @@
+#include <iostream>
+#include <string>
+#include "uci.h"
+
+/*
+* uci
+* Speaks the Universal Chess Interface on stdin/stdout, so the engine can be
+* run by GUIs and tournament managers (cutechess-cli, fastchess, ...).
+*/
+
+int main(void) {
+    std::ios::sync_with_stdio(false);
+    uci::Engine engine(std::cout);
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!engine.execute(line)) return 0;
+    }
+    return 0;
+}
@@ -0,0 +1,334 @@
+#ifndef UCI_H
+#define UCI_H
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "background_search.h"
+#include "board.h"
+#include "dfs.h"
+#include "fen.h"
+#include "game.h"
+#include "lawyer.h"
+#include "move.h"
+#include "nnue.h"
+#include "opening_book.h"
+#include "oracle.h"
+#include "pawn_structure.h"
+#include "tablebase.h"
+
+/*
+* Universal Chess Interface front end.
+*
+* uci::Engine takes one command line at a time and writes its replies to a
+* stream. Searches run on their own thread so that `stop` and `isready` are
+* answered while thinking; `bestmove` is written by that thread.
+*
+* Timed searches deepen one ply at a time (see DFS::explore with a SearchControl)
+* and are stopped by its deadline once their budget is spent. The move of the
+* deepest finished iteration is played.
+*/
+
+namespace uci {
+
+inline constexpr const char* ENGINE_NAME = "jco";
+inline constexpr int MAX_SEARCH_DEPTH = 64;  // depth of searches bounded by time or `stop`
+inline constexpr int DEFAULT_HASH_MB = 16;
+inline constexpr int MAX_HASH_MB = 1024;
+
+// Coordinate notation, e.g. "e2e4" or "e7e8q"
+inline std::string move_to_string(const Move& move) {
+    std::string out;
+    out += static_cast<char>('a' + move.from_x());
+    out += static_cast<char>('1' + move.from_y());
+    out += static_cast<char>('a' + move.to_x());
+    out += static_cast<char>('1' + move.to_y());
+    if (move.has_promotion()) {
+        out += static_cast<char>(std::tolower(static_cast<unsigned char>(kind_to_char(move.get_promotion()))));
+    }
+    return out;
+}
+
+// The legal move of `board` written as `text` in coordinate notation
+inline std::optional<Move> parse_move(const Board& board, std::string_view text) {
+    for (const Move& move : Lawyer::instance().legal_moves(board)) {
+        if (move_to_string(move) == text) return move;
+    }
+    return std::nullopt;
+}
+
+// Arguments of `go`. Times are in milliseconds, -1 when absent.
+struct Limits {
+    int depth = 0;
+    int64_t movetime = -1;
+    int64_t wtime = -1;
+    int64_t btime = -1;
+    int64_t winc = 0;
+    int64_t binc = 0;
+    int movestogo = 0;
+    bool infinite = false;
+};
+
+inline Limits parse_go(std::istringstream& args) {
+    Limits limits;
+    std::string token;
+    while (args >> token) {
+        if (token == "depth") args >> limits.depth;
+        else if (token == "movetime") args >> limits.movetime;
+        else if (token == "wtime") args >> limits.wtime;
+        else if (token == "btime") args >> limits.btime;
+        else if (token == "winc") args >> limits.winc;
+        else if (token == "binc") args >> limits.binc;
+        else if (token == "movestogo") args >> limits.movestogo;
+        else if (token == "infinite") limits.infinite = true;
+    }
+    if (limits.depth <= 0 && limits.movetime < 0 && limits.wtime < 0 && limits.btime < 0) limits.infinite = true;
+    return limits;
+}
+
+// Milliseconds to think for, or -1 to think until the depth is reached or `stop`.
+inline int64_t time_budget(const Limits& limits, bool white_to_move) {
+    if (limits.movetime >= 0) return limits.movetime;
+    const int64_t remaining = white_to_move ? limits.wtime : limits.btime;
+    if (remaining < 0) return -1;
+    const int64_t increment = white_to_move ? limits.winc : limits.binc;
+    const int64_t moves_left = limits.movestogo > 0 ? limits.movestogo : 30;
+    const int64_t budget = remaining / moves_left + increment / 2;
+    return std::max<int64_t>(1, std::min(budget, remaining / 2));
+}
+
+class Engine {
+public:
+    explicit Engine(std::ostream& out) : out_(out), oracle_(make_material_oracle()) {}
+
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    ~Engine() { stop(); }
+
+    // Run one command. Returns false once the engine should exit.
+    bool execute(const std::string& line) {
+        std::istringstream args(line);
+        std::string command;
+        args >> command;
+        if (command == "uci") {
+            write("id name " + std::string(ENGINE_NAME) + "\n"
+                  "id author jco\n"
+                  "option name Hash type spin default " + std::to_string(DEFAULT_HASH_MB) +
+                  " min 1 max " + std::to_string(MAX_HASH_MB) + "\n"
+                  "option name Threads type spin default 1 min 1 max 1\n"
+                  "option name Evaluation type combo default material var material var structural var nnue\n"
+                  "option name EvalFile type string default <empty>\n"
+                  "option name BookFile type string default <empty>\n"
+                  "option name TablebasePath type string default <empty>\n"
+                  "uciok\n");
+        } else if (command == "isready") {
+            write("readyok\n");
+        } else if (command == "ucinewgame") {
+            stop();
+            game_.reset();
+        } else if (command == "position") {
+            stop();
+            position(args);
+        } else if (command == "go") {
+            stop();
+            go(parse_go(args));
+        } else if (command == "stop") {
+            stop();
+        } else if (command == "setoption") {
+            stop();
+            set_option(line);
+        } else if (command == "quit") {
+            stop();
+            return false;
+        }
+        return true;
+    }
+
+    // Block until the running search, if any, has written its bestmove.
+    void wait() {
+        if (search_thread_.joinable()) search_thread_.join();
+    }
+
+    const Game& game() const { return game_; }
+
+private:
+    std::ostream& out_;
+    std::mutex out_mutex_;
+    Game game_;
+    Oracle oracle_;
+    std::string evaluation_ = "material";
+    int hash_mb_ = DEFAULT_HASH_MB;
+    std::shared_ptr<const nnue::Network> network_;
+    std::shared_ptr<const book::OpeningBook> book_;
+    std::shared_ptr<const tablebase::Tablebase> tablebase_;
+    std::thread search_thread_;
+    std::atomic<bool> stop_{false};
+
+    void write(const std::string& text) {
+        std::lock_guard<std::mutex> lock(out_mutex_);
+        out_ << text << std::flush;
+    }
+
+    void stop() {
+        stop_.store(true);
+        wait();
+    }
+
+    // position (startpos | fen <fen>) [moves <move>...]
+    void position(std::istringstream& args) {
+        std::string token;
+        args >> token;
+        try {
+            if (token == "startpos") {
+                game_.reset();
+                args >> token;
+            } else if (token == "fen") {
+                std::string fen;
+                while (args >> token && token != "moves") fen += (fen.empty() ? "" : " ") + token;
+                game_.load_fen(fen);
+            } else {
+                return;
+            }
+        } catch (const std::exception& ex) {
+            write(std::string("info string ") + ex.what() + "\n");
+            return;
+        }
+        if (token != "moves") return;
+        while (args >> token) {
+            const std::optional<Move> move = parse_move(game_.board(), token);
+            if (!move.has_value() || game_.verify_and_move(move.value()) != 0) {
+                write("info string illegal move " + token + "\n");
+                return;
+            }
+        }
+    }
+
+    // setoption name <name> [value <value>]
+    void set_option(const std::string& line) {
+        const size_t name_at = line.find(" name ");
+        if (name_at == std::string::npos) return;
+        const size_t value_at = line.find(" value ", name_at);
+        std::string name = line.substr(name_at + 6, value_at == std::string::npos ? std::string::npos : value_at - name_at - 6);
+        const std::string value = value_at == std::string::npos ? "" : line.substr(value_at + 7);
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+        try {
+            if (name == "hash") {
+                hash_mb_ = std::clamp(std::stoi(value), 1, MAX_HASH_MB);
+            } else if (name == "threads") {
+                // Single-threaded search; accepted so harnesses can set it
+            } else if (name == "evaluation") {
+                evaluation_ = value;
+            } else if (name == "evalfile") {
+                network_ = (value.empty() || value == "<empty>") ? nullptr : nnue::Network::load(value);
+            } else if (name == "bookfile") {
+                book_ = (value.empty() || value == "<empty>") ? nullptr : book::OpeningBook::open(value);
+            } else if (name == "tablebasepath") {
+                tablebase_ = (value.empty() || value == "<empty>") ? nullptr : tablebase::Tablebase::open(value);
+            } else {
+                write("info string unknown option " + name + "\n");
+                return;
+            }
+        } catch (const std::exception& ex) {
+            write(std::string("info string ") + ex.what() + "\n");
+        }
+        rebuild_oracle();
+    }
+
+    // Hash is the memory of the structural evaluation's pawn hash table, the only table the engine keeps.
+    void rebuild_oracle() {
+        if (evaluation_ == "structural") {
+            int size_log2 = 1;
+            while ((size_t{1} << (size_log2 + 1)) * sizeof(pawn_structure::Entry) <= (static_cast<size_t>(hash_mb_) << 20)) {
+                ++size_log2;
+            }
+            oracle_ = make_structural_oracle(size_log2);
+        } else if (evaluation_ == "nnue" && network_) {
+            oracle_ = make_nnue_oracle(network_);
+        } else {
+            if (evaluation_ == "nnue") write("info string nnue evaluation needs EvalFile; using material\n");
+            oracle_ = make_material_oracle();
+        }
+    }
+
+    void go(const Limits& limits) {
+        const Board board = game_.board();
+        const int halfmove_clock = game_.get_halfmove_clock();
+        if (game_.status() != GameStatus::Ongoing) {
+            write("bestmove 0000\n");
+            return;
+        }
+        const int64_t budget = time_budget(limits, board.is_white_to_move());
+        const int depth = limits.depth > 0 ? std::min(limits.depth, MAX_SEARCH_DEPTH) : MAX_SEARCH_DEPTH;
+        stop_.store(false);
+        search_thread_ = std::thread([this, board, halfmove_clock, limits, depth, budget] {
+            search(board, halfmove_clock, limits, depth, budget);
+        });
+    }
+
+    // Runs on search_thread_: deepen until done, out of time or stopped, then answer.
+    void search(const Board& board, int halfmove_clock, const Limits& limits, int depth, int64_t budget) {
+        const auto start = std::chrono::steady_clock::now();
+        auto elapsed_ms = [&] {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        };
+        DFS agent(oracle_, board.is_white_to_move());
+        agent.set_max_depth(depth);
+        if (book_) agent.set_book(book_);
+        if (tablebase_) agent.set_tablebase(tablebase_);
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+        if (budget >= 0) deadline = start + std::chrono::milliseconds(budget);
+        std::optional<Move> best;
+        {
+            BackgroundSearch running(agent, board, halfmove_clock, deadline);
+            int reported = 0;
+            auto report = [&] {
+                const int depth = running.depth();
+                if (depth <= reported) return;
+                reported = depth;
+                const int64_t ms = elapsed_ms();
+                const uint64_t nodes = running.nodes();
+                write("info depth " + std::to_string(depth) + " nodes " + std::to_string(nodes) +
+                      " time " + std::to_string(ms) + " nps " + std::to_string(ms > 0 ? nodes * 1000 / ms : nodes) + "\n");
+            };
+            while (!running.done()) {
+                if (stop_.load()) running.cancel();
+                report();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            report();
+            try {
+                best.emplace(running.take());
+            } catch (const std::exception&) {
+                // Stopped before depth 1 finished
+            }
+        }
+        if (!best.has_value()) {
+            const std::vector<Move> moves = Lawyer::instance().legal_moves(board);
+            if (!moves.empty()) best.emplace(moves.front());
+        }
+        // `go infinite` answers only once told to stop
+        while (limits.infinite && !stop_.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        std::string answer = "bestmove " + (best.has_value() ? move_to_string(best.value()) : std::string("0000"));
+        if (best.has_value() && agent.ponder_move().has_value()) {
+            answer += " ponder " + move_to_string(agent.ponder_move().value());
+        }
+        write(answer + "\n");
+    }
+};
+
+} // namespace uci
+
+#endif // UCI_H
@@ -0,0 +1,60 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+#include "piece.h"
+
+/*
+* Zobrist hashing keys.
+* One random 64-bit key per (colour, piece kind, square), castling rights combination,
+* en-passant file and side to move. A position's hash is the XOR of the keys of
+* everything in it, so a move updates it with a handful of XORs (see Board).
+*
+* Keys come from a fixed-seed splitmix64, so hashes are identical across builds
+* and machines and can be stored on disk.
+*/
+
+namespace zobrist {
+
+struct Keys {
+    uint64_t piece[2][6][64];    // [white][kind][y * 8 + x]
+    uint64_t castling[16];       // indexed by castling_index(); [0] is 0
+    uint64_t en_passant_file[8];
+    uint64_t black_to_move;
+};
+
+constexpr uint64_t splitmix64(uint64_t& state) {
+    state += 0x9E3779B97F4A7C15ULL;
+    uint64_t z = state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr Keys make_keys() {
+    Keys keys{};
+    uint64_t state = 0x4A434F4348455353ULL;  // "JCOCHESS"
+    for (int c = 0; c < 2; ++c)
+        for (int k = 0; k < 6; ++k)
+            for (int sq = 0; sq < 64; ++sq)
+                keys.piece[c][k][sq] = splitmix64(state);
+    keys.castling[0] = 0;
+    for (int i = 1; i < 16; ++i) keys.castling[i] = splitmix64(state);
+    for (int f = 0; f < 8; ++f) keys.en_passant_file[f] = splitmix64(state);
+    keys.black_to_move = splitmix64(state);
+    return keys;
+}
+
+inline constexpr Keys KEYS = make_keys();
+
+inline uint64_t piece_key(PieceKind kind, bool white, int x, int y) {
+    return KEYS.piece[white ? 1 : 0][static_cast<int>(kind)][y * 8 + x];
+}
+
+inline int castling_index(bool wk, bool wq, bool bk, bool bq) {
+    return (wk ? 1 : 0) | (wq ? 2 : 0) | (bk ? 4 : 0) | (bq ? 8 : 0);
+}
+
+} // namespace zobrist
+
+#endif // ZOBRIST_H